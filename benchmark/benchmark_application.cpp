@@ -0,0 +1,339 @@
+#include "benchmark_application.h"
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+using namespace isometric;
+using namespace isometric::benchmark;
+
+namespace {
+
+    constexpr unsigned tile_width = 64;
+    constexpr unsigned tile_height = 32;
+    constexpr uint32_t seed = 0x15043E7Fu;
+    constexpr size_t batch_size = 16384;           // Points or tiles per batch, small enough to stay in the cache
+    constexpr size_t batches_per_sample = 16;      // So a sample is long enough to time to the microsecond
+    constexpr size_t micro_samples = 500;
+    constexpr double frame_delta_time = 1.0 / 60.0;
+
+    // Stops the compiler from optimising away work whose results are never used:
+    volatile uint64_t result_sink = 0;
+
+    std::vector<std::pair<std::string, std::string>> parameters(
+        std::initializer_list<std::pair<std::string, size_t>> values
+    )
+    {
+        std::vector<std::pair<std::string, std::string>> result;
+        for (const auto& value : values)
+        {
+            result.emplace_back(value.first, std::to_string(value.second));
+        }
+
+        return result;
+    }
+
+    // Time a microbenchmark whose batch function does batch_size operations:
+    template<class F> void run_micro(
+        benchmark_suite& suite,
+        const std::string& name,
+        const std::vector<std::pair<std::string, std::string>>& benchmark_parameters,
+        F&& batch
+    )
+    {
+        suite.run(name, benchmark_parameters, batch_size * batches_per_sample, 5, micro_samples, [&](size_t sample) {
+            for (size_t i = 0; i < batches_per_sample; i++)
+            {
+                batch(sample * batches_per_sample + i);
+            }
+        });
+    }
+}
+
+bool benchmark_application::on_start()
+{
+    tiles_image = assets::image::load("benchmark_tiles", "content/grassland_tiles.png");
+    if (!tiles_image)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load the benchmark tile images");
+        return false;
+    }
+
+    SDL_Log("Running benchmarks%s%s", options.filter.empty() ? "" : " matching ", options.filter.c_str());
+
+    benchmark_suite suite(options.filter);
+    run_transform_benchmarks(suite);
+    run_tile_map_benchmarks(suite);
+    run_world_benchmarks(suite);
+
+    succeeded = suite.write_json(options.output_path, options.build_name);
+
+    // Nothing is left to do once every scenario has run:
+    shutdown();
+    return application::on_start();
+}
+
+std::shared_ptr<tile_map> benchmark_application::create_map(unsigned size, unsigned layer_count) const
+{
+    // Chunked storage with only default images, so that even the largest maps take no time or memory to create:
+    auto map = tile_map::create(size, size, tile_width, tile_height, tile_map_storage::chunked);
+    map->set_seed(seed);
+
+    map->add_image(tile_image::create("selection", 0, tiles_image->get_texture(), 960, 160, tile_width, tile_height));
+    map->set_selection_image(0);
+
+    for (unsigned i = 1, source_x = 0; i < 16; i++, source_x += 64)
+    {
+        map->add_image(tile_image::create(
+            "grass" + std::to_string(i), i, tiles_image->get_texture(), source_x, 0, tile_width, tile_height
+        ));
+    }
+
+    map->add_image(tile_image::create("bush1", 99, tiles_image->get_texture(), 512, 320, tile_width, tile_height * 2));
+
+    // The ground is static (drawn from cached chunks), every layer on top of it is dynamic and drawn tile by tile:
+    const unsigned ground_layer = map->add_layer("ground");
+    map->set_layer_static(ground_layer);
+    for (unsigned i = 1; i < 16; i++)
+    {
+        map->add_layer_default_image(ground_layer, i);
+    }
+
+    for (unsigned layer = 1; layer < layer_count; layer++)
+    {
+        const unsigned layer_id = map->add_layer("layer" + std::to_string(layer));
+        map->add_layer_default_image(layer_id, 99);
+    }
+
+    return map;
+}
+
+void benchmark_application::run_transform_benchmarks(benchmark_suite& suite)
+{
+    const unsigned map_size = 4096;
+    auto map = create_map(map_size, 1);
+    auto camera = camera::create(0, 0, get_setup().screen_width, get_setup().screen_height, 1000.0f, 1000.0f);
+    const transform benchmark_transform(camera, map);
+    const view_transform view = benchmark_transform.get_view();
+
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> tile_distribution(0, static_cast<int>(map_size) - 1);
+    std::uniform_real_distribution<float> pixel_x_distribution(0.0f, static_cast<float>(get_setup().screen_width));
+    std::uniform_real_distribution<float> pixel_y_distribution(0.0f, static_cast<float>(get_setup().screen_height));
+
+    std::vector<SDL_Point> tile_points(batch_size);
+    std::vector<SDL_FPoint> pixel_points(batch_size);
+    std::vector<SDL_FPoint> converted(batch_size);
+
+    for (size_t i = 0; i < batch_size; i++)
+    {
+        tile_points[i] = SDL_Point{ tile_distribution(generator), tile_distribution(generator) };
+        pixel_points[i] = SDL_FPoint{ pixel_x_distribution(generator), pixel_y_distribution(generator) };
+    }
+
+    const auto map_parameters = parameters({ { "map_size", map_size } });
+
+    run_micro(suite, "transform/world_tile_to_viewport_pixels", map_parameters, [&](size_t) {
+        for (size_t i = 0; i < batch_size; i++)
+        {
+            converted[i] = benchmark_transform.world_tile_to_viewport_pixels(tile_points[i]);
+        }
+        result_sink = result_sink + static_cast<uint64_t>(converted[batch_size - 1].x);
+    });
+
+    run_micro(suite, "transform/viewport_pixels_to_world_tile", map_parameters, [&](size_t) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < batch_size; i++)
+        {
+            const SDL_Point tile_point = benchmark_transform.viewport_pixels_to_world_tile(pixel_points[i]);
+            sum += static_cast<uint64_t>(tile_point.x + tile_point.y);
+        }
+        result_sink = result_sink + sum;
+    });
+
+    run_micro(suite, "view_transform/tiles_to_viewport", map_parameters, [&](size_t) {
+        view.tiles_to_viewport(tile_points.data(), converted.data(), batch_size);
+        result_sink = result_sink + static_cast<uint64_t>(converted[batch_size - 1].x);
+    });
+
+    run_micro(suite, "view_transform/viewport_to_tile", map_parameters, [&](size_t) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < batch_size; i++)
+        {
+            const SDL_Point tile_point = view.viewport_to_tile(pixel_points[i]);
+            sum += static_cast<uint64_t>(tile_point.x + tile_point.y);
+        }
+        result_sink = result_sink + sum;
+    });
+}
+
+void benchmark_application::run_tile_map_benchmarks(benchmark_suite& suite)
+{
+    for (unsigned map_size : { 256u, 4096u, 16384u })
+    {
+        auto map = create_map(map_size, 2);
+
+        // Every other chunk has its tiles written, so reads go through both default images and stored chunks:
+        for (unsigned y = 0; y < map_size; y += 2 * tile_map::chunk_size)
+        {
+            for (unsigned x = 0; x < map_size; x += 2 * tile_map::chunk_size)
+            {
+                map->set_tile(x, y).set_image_id(1, 99);
+            }
+        }
+
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<unsigned> distribution(0, map_size - 1);
+        std::vector<SDL_Point> positions(batch_size);
+
+        for (auto& position : positions)
+        {
+            const unsigned x = distribution(generator);
+            position = SDL_Point{ static_cast<int>(x), static_cast<int>(distribution(generator)) };
+        }
+
+        const auto map_parameters = parameters({ { "map_size", map_size }, { "layers", 2 } });
+        const std::string size_name = std::to_string(map_size);
+
+        run_micro(suite, "tile_map/get_tile/random/" + size_name, map_parameters, [&](size_t) {
+            uint64_t sum = 0;
+            for (const SDL_Point& position : positions)
+            {
+                tile map_tile = map->get_tile(position.x, position.y);
+                sum += map_tile.get_image_id(0) + map_tile.get_image_id(1);
+            }
+            result_sink = result_sink + sum;
+        });
+
+        // Rows at a time, the order the renderer reads tiles in:
+        run_micro(suite, "tile_map/get_tile/sequential/" + size_name, map_parameters, [&](size_t batch) {
+            const unsigned row_length = std::min<unsigned>(map_size, 256);
+            const unsigned first_y = static_cast<unsigned>(batch * batch_size / row_length) % map_size;
+            uint64_t sum = 0;
+
+            for (size_t i = 0; i < batch_size; i++)
+            {
+                const unsigned x = static_cast<unsigned>(i % row_length);
+                const unsigned y = (first_y + static_cast<unsigned>(i / row_length)) % map_size;
+
+                tile map_tile = map->get_tile(x, y);
+                sum += map_tile.get_image_id(0) + map_tile.get_image_id(1);
+            }
+            result_sink = result_sink + sum;
+        });
+    }
+}
+
+void benchmark_application::run_world_benchmarks(benchmark_suite& suite)
+{
+    std::vector<unsigned> map_sizes = { 256, 1024, 4096, 16384 };
+    if (options.quick) map_sizes = { 256, 16384 };
+
+    for (unsigned map_size : map_sizes)
+    {
+        for (unsigned layer_count : { 1u, 3u })
+        {
+            for (size_t entity_count : { size_t(0), size_t(10000) })
+            {
+                run_world_scenario(suite, map_size, layer_count, entity_count);
+            }
+        }
+    }
+}
+
+void benchmark_application::run_world_scenario(
+    benchmark_suite& suite,
+    unsigned map_size,
+    unsigned layer_count,
+    size_t entity_count
+)
+{
+    const std::string name = "world/render/map_" + std::to_string(map_size) + "/layers_" +
+        std::to_string(layer_count) + "/entities_" + std::to_string(entity_count);
+
+    if (!suite.should_run(name)) return;
+
+    auto map = create_map(map_size, layer_count);
+    auto camera = camera::create(0, 0, get_setup().screen_width, get_setup().screen_height);
+    auto benchmark_world = std::make_shared<world>(map, camera);
+
+    // Entities are scattered over the whole map and wander, so most frames have a few in view and the rest are
+    // culled, as in a game:
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> x_distribution(0.0f, static_cast<float>(map_size * tile_width));
+    std::uniform_real_distribution<float> y_distribution(0.0f, static_cast<float>(map_size * tile_height / 2));
+    std::uniform_real_distribution<float> speed_distribution(-32.0f, 32.0f);
+
+    entity_store& entities = benchmark_world->get_entities();
+    entities.reserve(entity_count);
+
+    for (size_t i = 0; i < entity_count; i++)
+    {
+        const entity handle = entities.create(
+            SDL_FPoint{ x_distribution(generator), y_distribution(generator) },
+            static_cast<tile_image_index>(1 + i % 15),
+            entity_visible | entity_moving
+        );
+
+        entities.set_velocity(
+            entities.get_index(handle), SDL_FPoint{ speed_distribution(generator), speed_distribution(generator) }
+        );
+    }
+
+    // The camera circles once over the timed frames. The camera's position is the top left of the viewport (in
+    // columns and rows), so the circle is kept within the positions where the whole viewport is on the map:
+    const float max_x = std::max(
+        static_cast<float>(map_size) - static_cast<float>(benchmark_world->get_max_horizontal_tiles()) - 1.0f, 0.0f
+    );
+    const float max_y = std::max(
+        static_cast<float>(map_size) - static_cast<float>(benchmark_world->get_max_vertical_tiles()) - 1.0f, 0.0f
+    );
+
+    if (max_x <= 0.0f || max_y <= 0.0f)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s: the map is smaller than the screen, frames won't be full",
+            name.c_str());
+    }
+
+    // A row is half a tile high, so the circle covers twice as many rows as columns where it can:
+    const float centre_x = max_x / 2.0f;
+    const float centre_y = max_y / 2.0f;
+    const float radius_x = std::min(centre_x, 64.0f);
+    const float radius_y = std::min(centre_y, radius_x * 2.0f);
+    const size_t warmup_frames = 30;
+    const size_t frame_count = std::max<size_t>(options.frames, 1);
+    SDL_Renderer* renderer = get_renderer();
+    rendering::render_counters frame_totals;
+
+    suite.run(name, parameters({
+        { "map_size", map_size },
+        { "layers", layer_count },
+        { "entities", entity_count },
+        { "frames", frame_count }
+    }), 1, warmup_frames, frame_count, [&](size_t frame) {
+        const float angle = 6.2831853f * static_cast<float>(frame) / static_cast<float>(frame_count);
+        camera->set_current_pos(centre_x + radius_x * std::cos(angle), centre_y + radius_y * std::sin(angle));
+
+        benchmark_world->update(frame_delta_time);
+        benchmark_world->sync();
+
+        get_graphics()->clear(get_setup().background_color);
+        benchmark_world->render_frame(renderer, frame_delta_time);
+        rendering::render_layer::present(renderer);
+
+        if (frame < warmup_frames) return;
+
+        const rendering::render_counters& counters = rendering::render_layer::get_last_frame();
+        frame_totals.draw_calls += counters.draw_calls;
+        frame_totals.texture_switches += counters.texture_switches;
+        frame_totals.vertices += counters.vertices;
+        frame_totals.covered_pixels += counters.covered_pixels;
+        frame_totals.screen_pixels += counters.screen_pixels;
+    });
+
+    // Counted per frame, so submission can be told apart from culling when a scenario gets slower:
+    const double frames = static_cast<double>(frame_count);
+    suite.add_counter("draw_calls", static_cast<double>(frame_totals.draw_calls) / frames);
+    suite.add_counter("texture_switches", static_cast<double>(frame_totals.texture_switches) / frames);
+    suite.add_counter("vertices", static_cast<double>(frame_totals.vertices) / frames);
+    suite.add_counter("overdraw", frame_totals.get_overdraw());
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <isometric.h>
+#include <string>
+#include <vector>
+#include "benchmark_suite.h"
+
+namespace isometric::benchmark {
+
+    struct benchmark_options
+    {
+        std::string output_path = "benchmark_results.json";
+        std::string filter;             // Only run scenarios with this in their name
+        std::string build_name;         // Written to the results to tell builds apart
+        size_t frames = 300;            // Frames timed per world scenario, after warming up
+        bool quick = false;             // Only the smallest and largest map of each world scenario
+    };
+
+    /// <summary>
+    /// Runs every benchmark scenario from on_start with the headless renderer, then shuts down. Every scenario is
+    /// seeded and scripted (the camera follows the same path and every frame has the same delta time), so runs of
+    /// different builds on the same machine can be compared.
+    /// </summary>
+    class benchmark_application : public isometric::application
+    {
+    private:
+        benchmark_options options;
+        std::unique_ptr<isometric::assets::image> tiles_image = nullptr;
+        bool succeeded = false;
+
+        std::shared_ptr<tile_map> create_map(unsigned size, unsigned layer_count) const;
+
+        void run_transform_benchmarks(benchmark_suite& suite);
+        void run_tile_map_benchmarks(benchmark_suite& suite);
+        void run_world_benchmarks(benchmark_suite& suite);
+
+        void run_world_scenario(benchmark_suite& suite, unsigned map_size, unsigned layer_count, size_t entity_count);
+
+    public:
+        void set_options(const benchmark_options& options) { this->options = options; }
+
+        /// <returns>True once every scenario ran and the results were written</returns>
+        bool has_succeeded() const { return succeeded; }
+
+    protected:
+        bool on_start() override;
+    };
+
+}
@@ -0,0 +1,113 @@
+#include "benchmark_suite.h"
+#include <fstream>
+#include <cstdio>
+
+using namespace isometric::benchmark;
+
+namespace {
+
+    std::string json_string(const std::string& text)
+    {
+        std::string quoted = "\"";
+
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\') quoted += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) quoted += c;
+        }
+
+        return quoted + "\"";
+    }
+
+    std::string json_number(double value)
+    {
+        char number[64];
+        std::snprintf(number, sizeof(number), "%.6f", value);
+        return number;
+    }
+}
+
+void benchmark_suite::log_result(const benchmark_result& result)
+{
+    const auto& samples = result.samples;
+
+    if (result.operations_per_sample > 1)
+    {
+        SDL_Log("%-60s %8.2f ns/op  (p99 %.3fms per %llu)", result.name.c_str(), result.get_median_ns_per_operation(),
+            samples.get_percentile_ms(99.0), static_cast<unsigned long long>(result.operations_per_sample));
+    }
+    else
+    {
+        SDL_Log("%-60s p50 %7.3fms  p90 %7.3fms  p99 %7.3fms  p99.9 %7.3fms  max %7.3fms", result.name.c_str(),
+            samples.get_percentile_ms(50.0), samples.get_percentile_ms(90.0), samples.get_percentile_ms(99.0),
+            samples.get_percentile_ms(99.9), samples.get_max_ms());
+    }
+}
+
+bool benchmark_suite::write_json(const std::string& path, const std::string& build_name) const
+{
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open '%s' to write the benchmark results", path.c_str());
+        return false;
+    }
+
+    out << "{\n  \"build\": " << json_string(build_name) << ",\n";
+    out << "  \"platform\": " << json_string(SDL_GetPlatform()) << ",\n";
+    out << "  \"architecture_bits\": " << (application::is_64bit() ? 64 : 32) << ",\n";
+    out << "  \"scenarios\": [";
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const benchmark_result& result = results[i];
+        const auto& samples = result.samples;
+
+        out << (i == 0 ? "\n" : ",\n") << "    {\n";
+        out << "      \"name\": " << json_string(result.name) << ",\n";
+        out << "      \"parameters\": {";
+
+        for (size_t p = 0; p < result.parameters.size(); p++)
+        {
+            out << (p == 0 ? " " : ", ") << json_string(result.parameters[p].first) << ": "
+                << json_string(result.parameters[p].second);
+        }
+
+        out << " },\n";
+        out << "      \"counters\": {";
+
+        for (size_t c = 0; c < result.counters.size(); c++)
+        {
+            out << (c == 0 ? " " : ", ") << json_string(result.counters[c].first) << ": "
+                << json_number(result.counters[c].second);
+        }
+
+        out << " },\n";
+        out << "      \"samples\": " << samples.get_count() << ",\n";
+        out << "      \"operations_per_sample\": " << result.operations_per_sample << ",\n";
+        out << "      \"median_ns_per_operation\": " << json_number(result.get_median_ns_per_operation()) << ",\n";
+        out << "      \"mean_ms\": " << json_number(samples.get_mean_ms()) << ",\n";
+        out << "      \"min_ms\": " << json_number(samples.get_min_ms()) << ",\n";
+        out << "      \"p50_ms\": " << json_number(samples.get_percentile_ms(50.0)) << ",\n";
+        out << "      \"p90_ms\": " << json_number(samples.get_percentile_ms(90.0)) << ",\n";
+        out << "      \"p99_ms\": " << json_number(samples.get_percentile_ms(99.0)) << ",\n";
+        out << "      \"p99_9_ms\": " << json_number(samples.get_percentile_ms(99.9)) << ",\n";
+        out << "      \"max_ms\": " << json_number(samples.get_max_ms()) << ",\n";
+        out << "      \"budget_ms\": " << json_number(samples.get_budget_ms()) << ",\n";
+        out << "      \"over_budget\": " << samples.get_over_budget_count() << ",\n";
+        out << "      \"over_double_budget\": " << samples.get_over_double_budget_count() << "\n";
+        out << "    }";
+    }
+
+    out << "\n  ]\n}\n";
+    out.close();
+
+    if (!out)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write the benchmark results to '%s'", path.c_str());
+        return false;
+    }
+
+    SDL_Log("Wrote %zu benchmark results to '%s'", results.size(), path.c_str());
+    return true;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <isometric.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include "../source/tools/stopwatch.h"
+#include "../source/tools/frame_time_histogram.h"
+
+namespace isometric::benchmark {
+
+    /// <summary>
+    /// The timings of one scenario. Each sample is one frame, or one batch of operations_per_sample calls for
+    /// microbenchmarks.
+    /// </summary>
+    struct benchmark_result
+    {
+        std::string name;
+        std::vector<std::pair<std::string, std::string>> parameters;
+        uint64_t operations_per_sample = 1;
+        tools::frame_time_histogram samples;
+        std::vector<std::pair<std::string, double>> counters;   // Averages per sample, such as draw calls per frame
+
+        /// <returns>The median time of a single operation in nanoseconds</returns>
+        double get_median_ns_per_operation() const
+        {
+            return samples.get_percentile_ms(50.0) * 1000000.0 / static_cast<double>(operations_per_sample);
+        }
+    };
+
+    /// <summary>
+    /// Runs scenarios and collects their timings, then writes them out as JSON so that runs of different builds can
+    /// be compared by a script
+    /// </summary>
+    class benchmark_suite
+    {
+    private:
+        std::string filter;
+        std::vector<benchmark_result> results;
+
+    public:
+        /// <param name="filter">Only scenarios with this in their name are run, empty to run everything</param>
+        explicit benchmark_suite(const std::string& filter = std::string()) : filter(filter) {}
+
+        bool should_run(const std::string& name) const
+        {
+            return filter.empty() || name.find(filter) != std::string::npos;
+        }
+
+        /// <summary>
+        /// Time a scenario, after running it a few times untimed so caches and textures are warmed up
+        /// </summary>
+        /// <param name="sample">Runs one sample of the scenario, called warmup_count + sample_count times</param>
+        template<class F> void run(
+            const std::string& name,
+            std::vector<std::pair<std::string, std::string>> parameters,
+            uint64_t operations_per_sample,
+            size_t warmup_count,
+            size_t sample_count,
+            F&& sample
+        )
+        {
+            if (!should_run(name)) return;
+
+            benchmark_result result;
+            result.name = name;
+            result.parameters = std::move(parameters);
+            result.operations_per_sample = operations_per_sample;
+
+            tools::stopwatch sample_stopwatch;
+
+            for (size_t i = 0; i < warmup_count + sample_count; i++)
+            {
+                sample_stopwatch.start(true);
+                sample(i);
+                sample_stopwatch.stop();
+
+                if (i >= warmup_count) result.samples.record(sample_stopwatch.get_elapsed_sec());
+            }
+
+            log_result(result);
+            results.push_back(std::move(result));
+        }
+
+        const std::vector<benchmark_result>& get_results() const { return results; }
+
+        /// <summary>
+        /// Add a counter to the result of the scenario that ran last
+        /// </summary>
+        void add_counter(const std::string& name, double value)
+        {
+            if (!results.empty()) results.back().counters.emplace_back(name, value);
+        }
+
+        /// <summary>
+        /// Write every result to a JSON file, with the percentiles of each scenario in milliseconds
+        /// </summary>
+        /// <returns>False if the file couldn't be written</returns>
+        bool write_json(const std::string& path, const std::string& build_name) const;
+
+        static void log_result(const benchmark_result& result);
+    };
+
+}
@@ -0,0 +1,64 @@
+#include <memory>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <exception>
+#include "benchmark_application.h"
+
+using namespace isometric;
+using namespace isometric::benchmark;
+
+namespace {
+
+    void print_usage()
+    {
+        SDL_Log("Usage: IsometricBenchmark [--output results.json] [--filter text] [--frames count] [--build name] "
+            "[--quick] [--window]");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    benchmark_options options;
+    render_mode rendering = render_mode::offscreen;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (argument == "--output" && has_value) options.output_path = argv[++i];
+        else if (argument == "--filter" && has_value) options.filter = argv[++i];
+        else if (argument == "--build" && has_value) options.build_name = argv[++i];
+        else if (argument == "--frames" && has_value) options.frames = std::strtoul(argv[++i], nullptr, 10);
+        else if (argument == "--quick") options.quick = true;
+        else if (argument == "--window") rendering = render_mode::window;
+        else
+        {
+            print_usage();
+            return -1;
+        }
+    }
+
+    try
+    {
+        application_setup setup;
+        setup.name = "Isometric Benchmark";
+        setup.background_color = 0x006bFFFF;
+        setup.vertical_sync = false;
+        setup.rendering = rendering;
+
+        auto app = application::create<benchmark_application>(setup);
+        app->set_options(options);
+
+        app->start();
+
+        return app->has_succeeded() ? 0 : -1;
+    }
+    catch (const std::exception& ex)
+    {
+        // A failed run has to be visible to whatever launched the benchmark, even without SDL's log:
+        std::fprintf(stderr, "IsometricBenchmark failed: %s\n", ex.what());
+        return -1;
+    }
+}
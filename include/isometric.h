@@ -5,4 +5,5 @@
 #include "../source/assets/asset_management.h"
 #include "../source/tools/random.h"
 #include "../source/rendering/graphics.h"
+#include "../source/rendering/sprite_batch.h"
 #include "../source/rendering/simple_bitmap_font.h"
\ No newline at end of file
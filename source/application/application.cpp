@@ -3,6 +3,7 @@
 #include <SDL_image.h>
 #include <SDL_ttf.h>
 #include <iostream>
+#include <algorithm>
 
 using namespace isometric;
 using namespace isometric::assets;
@@ -51,6 +52,7 @@ SDL_Renderer* application::get_renderer() const
 bool application::start()
 {
     SDL_Log("Application [%s] starting", setup.name.c_str());
+    main_thread = SDL_ThreadID();
 
     if (initialize())
     {
@@ -69,22 +71,55 @@ bool application::start()
 
     if (setup.broadcast_fps)
     {
+        const auto& frame_times = current_fps.get_frame_times();
+
         SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Minimum FPS: %.02f, Maximum FPS: %0.2f, Average FPS: %0.2f",
             current_fps.get_minimum(), current_fps.get_maximum(), current_fps.get_overall_average());
+
+        SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION,
+            "Frame times over %llu frames: p50 %.2fms, p90 %.2fms, p99 %.2fms, p99.9 %.2fms, max %.2fms",
+            static_cast<unsigned long long>(frame_times.get_count()), frame_times.get_percentile_ms(50.0),
+            frame_times.get_percentile_ms(90.0), frame_times.get_percentile_ms(99.0),
+            frame_times.get_percentile_ms(99.9), frame_times.get_max_ms());
+
+        SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Frames over the %.2fms budget: %llu, over twice the budget: %llu",
+            frame_times.get_budget_ms(), static_cast<unsigned long long>(frame_times.get_over_budget_count()),
+            static_cast<unsigned long long>(frame_times.get_over_double_budget_count()));
+
+        const auto& text_statistics = graphics->get_text_cache().get_statistics();
+        SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Text cache hits: %llu, misses: %llu, evictions: %llu",
+            static_cast<unsigned long long>(text_statistics.hits),
+            static_cast<unsigned long long>(text_statistics.misses),
+            static_cast<unsigned long long>(text_statistics.evictions));
+    }
+
+    if (setup.profiling && profile_capture_requested)
+    {
+        tools::profiler::write_chrome_trace(setup.profile_trace_path);
     }
 
+    // Jobs can refer to modules, so every job has to be done before the modules are released. Modules can still
+    // schedule jobs while they're unregistered, so the job system stays up until after that:
+    if (jobs) jobs->wait_for_all();
+
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Unregistering %llu modules", modules.size());
     unregister_all_modules();
 
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Stopping job system");
+    if (jobs) jobs->wait_for_all();
+    jobs.reset();
+
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Destroying asset manager");
     asset_manager->shutdown();
 
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Destroying SDL renderer");
+    graphics->get_text_cache().clear();
     graphics->renderer = nullptr;
     if (renderer) SDL_DestroyRenderer(renderer);
 
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Closing window");
     if (window) SDL_DestroyWindow(window);
+    if (offscreen_surface) SDL_FreeSurface(offscreen_surface);
 
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Shutting down SDL");
     TTF_Quit();
@@ -132,18 +167,93 @@ void application::main_loop()
         // Fixed framerate is determined by try_call_fixed_udpate() later
         current_fps.set_from_delta(delta_time);
 
-        graphics->clear(setup.background_color);
+        {
+            tools::profile_zone frame_zone("frame");
+
+            if (setup.pipelined_rendering)
+            {
+                run_pipelined_frame(delta_time);
+            }
+            else
+            {
+                run_frame(delta_time);
+            }
+
+            // If you get the following error in the log or console from SDL it means there wasn't enough drawn to
+            // enable SDL's internal batching. This error can be ignored.
+            // ERROR: SDL failed to get a vertex buffer for this Direct3D 9 rendering batch!
+            if (setup.rendering != render_mode::none) graphics->present();
+        }
+
+        if (setup.broadcast_fps) broadcast_fps(delta_time);
+
+        // Nothing is recording zones between frames, so the trace can't miss any:
+        if (profile_capture_requested)
+        {
+            profile_capture_requested = false;
+            tools::profiler::write_chrome_trace(setup.profile_trace_path);
+        }
+    }
+}
 
+void application::run_frame(double delta_time)
+{
+    {
+        tools::profile_zone zone("update");
         try_call_fixed_update(delta_time);
         on_update(delta_time);
+    }
 
-        // If you get the following error in the log or console from SDL it means there wasn't enough drawn to enable
-        // SDL's internal batching. This error can be ignored.
-        // ERROR: SDL failed to get a vertex buffer for this Direct3D 9 rendering batch!
-        graphics->present();
+    {
+        tools::profile_zone zone("sync");
+        on_sync();
+    }
 
-        if (setup.broadcast_fps) broadcast_fps(delta_time);
+    draw_frame(delta_time);
+
+    // Everything scheduled for this frame has to be finished before it's presented:
+    tools::profile_zone zone("wait_for_frame");
+    jobs->wait_for_frame();
+}
+
+void application::run_pipelined_frame(double delta_time)
+{
+    // Hand the last update over to rendering, then update the next frame on a worker while the main thread draws
+    // (SDL's renderer can only be used from the thread that created it). Frames are shown one frame later, but a
+    // frame takes as long as the slower of the two instead of both added together:
+    if (!pipeline_started)
+    {
+        // The first frame has no last update to hand over, so one is run first without any time passing:
+        tools::profile_zone zone("update");
+        on_update(0.0);
+        pipeline_started = true;
+    }
+
+    {
+        tools::profile_zone zone("sync");
+        on_sync();
     }
+
+    auto update_job = jobs->schedule([this, delta_time]() {
+        tools::profile_zone zone("update");
+        try_call_fixed_update(delta_time);
+        on_update(delta_time);
+    });
+
+    draw_frame(delta_time);
+
+    tools::profile_zone zone("wait_for_frame");
+    jobs->wait(update_job);
+    jobs->wait_for_frame();
+}
+
+void application::draw_frame(double delta_time)
+{
+    if (setup.rendering == render_mode::none) return;
+
+    tools::profile_zone zone("render");
+    graphics->clear(setup.background_color);
+    on_render(delta_time);
 }
 
 void application::broadcast_fps(double delta_time) const
@@ -160,9 +270,26 @@ void application::broadcast_fps(double delta_time) const
 
         SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Average FPS: %.02f, Average Fixed FPS: %0.2f",
             current_fps.get_average(), current_fixed_fps.get_average());
+
+        const auto& frame_times = current_fps.get_frame_times();
+        SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Frame time p50: %.2fms, p99: %.2fms, Stutters: %llu",
+            frame_times.get_percentile_ms(50.0), frame_times.get_percentile_ms(99.0),
+            static_cast<unsigned long long>(frame_times.get_over_budget_count()));
+
+        const auto& counters = get_render_counters();
+        SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Draw calls: %llu, Texture switches: %llu, Vertices: %llu, "
+            "Overdraw: %.2fx", static_cast<unsigned long long>(counters.draw_calls),
+            static_cast<unsigned long long>(counters.texture_switches),
+            static_cast<unsigned long long>(counters.vertices), counters.get_overdraw());
     }
 }
 
+void application::reset_frame_statistics()
+{
+    current_fps.reset_window();
+    current_fixed_fps.reset_window();
+}
+
 void application::try_call_fixed_update(double delta_time)
 {
     constexpr int max_steps = 5; // Maximum number of steps, to avoid degrading to an halt.
@@ -199,22 +326,183 @@ void application::try_call_fixed_update(double delta_time)
 
 void application::on_fixed_update(double fixed_delta_time)
 {
-    for (auto& m : modules)
+    run_modules(phase_fixed_update, [fixed_delta_time](module& m) { m.on_fixed_update(fixed_delta_time); });
+}
+
+void application::on_update(double delta_time)
+{
+    run_modules(phase_update, [delta_time](module& m) { m.on_update(delta_time); });
+    run_modules(phase_late_update, [delta_time](module& m) { m.on_late_update(delta_time); });
+}
+
+void application::build_module_schedule()
+{
+    module_schedule_dirty = false;
+    module_schedule.clear();
+
+    const std::vector<std::shared_ptr<module>> registered(modules.begin(), modules.end());
+    const size_t count = registered.size();
+
+    auto index_of = [&registered](const std::shared_ptr<module>& m) {
+        return static_cast<size_t>(std::find(registered.begin(), registered.end(), m) - registered.begin());
+    };
+
+    // Explicit orderings, must_follow[i][j] is true when module i has to run after module j:
+    std::vector<std::vector<bool>> must_follow(count, std::vector<bool>(count, false));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        for (const auto& after : registered[i]->run_after_modules)
+        {
+            const size_t j = index_of(after.lock());
+            if (j < count && j != i) must_follow[i][j] = true;
+        }
+
+        for (const auto& before : registered[i]->run_before_modules)
+        {
+            const size_t j = index_of(before.lock());
+            if (j < count && j != i) must_follow[j][i] = true;
+        }
+    }
+
+    // Put the modules in an order that satisfies the explicit orderings, keeping to the registration order otherwise:
+    std::vector<size_t> order;
+    std::vector<bool> placed(count, false);
+
+    while (order.size() < count)
+    {
+        size_t next = count;
+
+        for (size_t i = 0; i < count && next == count; i++)
+        {
+            if (placed[i]) continue;
+
+            bool ready = true;
+            for (size_t j = 0; j < count && ready; j++)
+            {
+                if (must_follow[i][j] && !placed[j]) ready = false;
+            }
+
+            if (ready) next = i;
+        }
+
+        if (next == count)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Module run_after/run_before orderings form a cycle, modules "
+                "will update one at a time in the order they were registered");
+
+            order.clear();
+            for (size_t i = 0; i < count; i++)
+            {
+                order.push_back(i);
+                for (size_t j = 0; j < count; j++) must_follow[i][j] = j < i;
+            }
+
+            break;
+        }
+
+        placed[next] = true;
+        order.push_back(next);
+    }
+
+    // A module waits for every module before it that it's ordered after or shares written state with. Dependencies
+    // only ever point back in the order, so the schedule can't deadlock:
+    for (size_t position = 0; position < count; position++)
     {
-        if (m && m->is_enabled()) m->on_fixed_update(fixed_delta_time);
+        const size_t i = order[position];
+        scheduled_module entry{ registered[i], {}, {} };
+        entry.run_inline = !registered[i]->access_declared;
+        entry.zone_names[phase_update] = tools::profiler::intern(registered[i]->name + "::on_update");
+        entry.zone_names[phase_late_update] = tools::profiler::intern(registered[i]->name + "::on_late_update");
+        entry.zone_names[phase_fixed_update] = tools::profiler::intern(registered[i]->name + "::on_fixed_update");
+
+        for (size_t earlier = 0; earlier < position; earlier++)
+        {
+            const size_t j = order[earlier];
+
+            if (must_follow[i][j] || registered[i]->conflicts_with(*registered[j]))
+            {
+                entry.dependencies.push_back(earlier);
+            }
+        }
+
+        // Only modules that declared their access and share no written state with any other module are sent to the
+        // job system, everything else is updated on the thread running the updates like before:
+        for (size_t j = 0; j < count && !entry.run_inline; j++)
+        {
+            if (j != i && registered[i]->conflicts_with(*registered[j])) entry.run_inline = true;
+        }
+
+        module_schedule.push_back(std::move(entry));
     }
 }
 
-void application::on_update(double delta_time)
+void application::run_modules(module_phase phase, const std::function<void(module&)>& call)
+{
+    if (module_schedule_dirty) build_module_schedule();
+
+    // Declared modules get a job even when disabled so that they still pass on the ordering of the modules around
+    // them. Inline modules run once every module they depend on is done, and are finished before anything after them
+    // is scheduled:
+    std::vector<tools::job_handle> module_jobs(module_schedule.size());
+    std::vector<tools::job_handle> dependencies;
+
+    for (size_t i = 0; i < module_schedule.size(); i++)
+    {
+        module* m = module_schedule[i].scheduled.get();
+        const char* zone_name = module_schedule[i].zone_names[phase];
+
+        if (module_schedule[i].run_inline)
+        {
+            for (size_t dependency : module_schedule[i].dependencies)
+            {
+                jobs->wait(module_jobs[dependency]);
+            }
+
+            if (!m->is_enabled()) continue;
+
+            // Modules that never declared their access keep running on the main thread (the update worker when
+            // rendering is pipelined), as they did before modules were scheduled:
+            SDL_assert(setup.pipelined_rendering || SDL_ThreadID() == main_thread);
+
+            tools::profile_zone zone(zone_name, "module");
+            call(*m);
+            continue;
+        }
+
+        dependencies.clear();
+        for (size_t dependency : module_schedule[i].dependencies)
+        {
+            dependencies.push_back(module_jobs[dependency]);
+        }
+
+        module_jobs[i] = jobs->schedule([m, zone_name, &call]() {
+            if (!m->is_enabled()) return;
+
+            tools::profile_zone zone(zone_name, "module");
+            call(*m);
+        }, dependencies);
+    }
+
+    for (const auto& module_job : module_jobs)
+    {
+        jobs->wait(module_job);
+    }
+}
+
+void application::on_sync()
 {
     for (auto& m : modules)
     {
-        if (m && m->is_enabled()) m->on_update(delta_time);
+        if (m && m->is_enabled()) m->on_sync();
     }
+}
 
+void application::on_render(double delta_time)
+{
     for (auto& m : modules)
     {
-        if (m && m->is_enabled()) m->on_late_update(delta_time);
+        if (m && m->is_enabled()) m->on_render(delta_time);
     }
 }
 
@@ -232,6 +520,11 @@ bool application::on_event(const SDL_Event& e)
             SDL_Log("Shutdown requested via escape key");
             return false; // Shutdown
         }
+
+        if (setup.profiling && e.key.keysym.scancode == setup.profile_capture_key && !e.key.repeat)
+        {
+            request_profile_capture();
+        }
         break;
     }
 
@@ -249,6 +542,11 @@ std::shared_ptr<isometric::assets::asset_management> isometric::application::get
     return asset_manager;
 }
 
+std::shared_ptr<isometric::tools::job_system> isometric::application::get_job_system() const
+{
+    return jobs;
+}
+
 bool application::initialize()
 {
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Application initializing");
@@ -271,8 +569,14 @@ bool application::initialize()
         // --------------------------------------------------------------------
         // SDL & EXTENSIONS INIT
 
-        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "SDL initializing subsystems");
-        if (SDL_Init(SDL_INIT_EVERYTHING) < 0)
+        // Without a window there's no need for video (or a display to provide it), SDL's software renderer and
+        // surfaces work without it:
+        const bool headless = setup.rendering != render_mode::window;
+        const Uint32 subsystems = headless ? SDL_INIT_TIMER | SDL_INIT_EVENTS : SDL_INIT_EVERYTHING;
+
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "SDL initializing subsystems%s",
+            headless ? " without video" : "");
+        if (SDL_Init(subsystems) < 0)
         {
             error << "Failed to initialize SDL: " << SDL_GetError();
             throw(error.str());
@@ -298,42 +602,87 @@ bool application::initialize()
         // Allow mouse click events when clicking to focus an SDL window
         SDL_SetHint(SDL_HINT_MOUSE_FOCUS_CLICKTHROUGH, setup.mouse_focus_clickthrough ? "1" : "0");
 
-        // --------------------------------------------------------------------
-        // SDL_WINDOW
-
-        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Creating SDL window with the resolution %d x %d", setup.screen_width, setup.screen_height);
-        if ((window = SDL_CreateWindow(
-            setup.name.c_str(),
-            SDL_WINDOWPOS_CENTERED,
-            SDL_WINDOWPOS_CENTERED,
-            setup.screen_width, setup.screen_height,
-            0
-        )) == 0)
+        if (!headless)
         {
-            error << "Failed to create a window: " << SDL_GetError();
-            throw(error.str());
-        }
+            // ----------------------------------------------------------------
+            // SDL_WINDOW
+
+            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Creating SDL window with the resolution %d x %d", setup.screen_width, setup.screen_height);
+            if ((window = SDL_CreateWindow(
+                setup.name.c_str(),
+                SDL_WINDOWPOS_CENTERED,
+                SDL_WINDOWPOS_CENTERED,
+                setup.screen_width, setup.screen_height,
+                0
+            )) == 0)
+            {
+                error << "Failed to create a window: " << SDL_GetError();
+                throw(error.str());
+            }
 
-        // --------------------------------------------------------------------
-        // SDL_RENDERER, ASSET MANAGER, & GRAPHICS
+            // ----------------------------------------------------------------
+            // SDL_RENDERER
 
-        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Creating SDL renderer");
-        Uint32 renderer_flags = setup.vertical_sync ? SDL_RENDERER_PRESENTVSYNC : 0;
-        if ((renderer = SDL_CreateRenderer(window, -1, renderer_flags)) == 0)
+            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Creating SDL renderer");
+            Uint32 renderer_flags = setup.vertical_sync ? SDL_RENDERER_PRESENTVSYNC : 0;
+            if ((renderer = SDL_CreateRenderer(window, -1, renderer_flags)) == 0)
+            {
+                error << "Failed to create the renderer: " << SDL_GetError();
+                throw(std::exception(error.str().c_str()));
+            }
+        }
+        else
         {
-            error << "Failed to create the renderer: " << SDL_GetError();
-            throw(std::exception(error.str().c_str()));
+            // ----------------------------------------------------------------
+            // OFFSCREEN SURFACE & SOFTWARE RENDERER
+
+            // Even when nothing is drawn, assets still need a renderer to create their textures and the viewport
+            // still needs a size, so that everything else behaves the same as with a window:
+            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Creating an offscreen surface with the resolution %d x %d",
+                setup.screen_width, setup.screen_height);
+
+            if ((offscreen_surface = SDL_CreateRGBSurfaceWithFormat(
+                0, setup.screen_width, setup.screen_height, 32, SDL_PIXELFORMAT_RGBA8888
+            )) == 0)
+            {
+                error << "Failed to create the offscreen surface: " << SDL_GetError();
+                throw(std::exception(error.str().c_str()));
+            }
+
+            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Creating SDL software renderer");
+            if ((renderer = SDL_CreateSoftwareRenderer(offscreen_surface)) == 0)
+            {
+                error << "Failed to create the software renderer: " << SDL_GetError();
+                throw(std::exception(error.str().c_str()));
+            }
         }
 
+        // --------------------------------------------------------------------
+        // ASSET MANAGER & GRAPHICS
+
         this->asset_manager = std::shared_ptr<asset_management>(new asset_management(renderer));
         this->graphics = std::shared_ptr<rendering::graphics>(new rendering::graphics(renderer));
 
+        // --------------------------------------------------------------------
+        // JOB SYSTEM
+
+        current_fps.set_budget(setup.target_fps);
+        current_fixed_fps.set_budget(setup.fixed_update_fps);
+
+        tools::profiler::set_thread_name("Main");
+        if (setup.profiling) tools::profiler::set_enabled();
+
+        this->jobs = std::make_shared<tools::job_system>(setup.worker_threads, setup.pin_worker_threads);
+
     }
     catch (std::exception ex)
     {
         // This is a simple way to show a message box, if main_window failed to create this will still work since 
-        // main_window will be NULL (the message box will just not have a parent):
-        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, setup.name.c_str(), ex.what(), window);
+        // main_window will be NULL (the message box will just not have a parent). Headless there's nobody to see it:
+        if (setup.rendering == render_mode::window)
+        {
+            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, setup.name.c_str(), ex.what(), window);
+        }
 
         // Output the error to the console, if you have one
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, ex.what());
@@ -360,6 +709,7 @@ void application::register_module(std::shared_ptr<module> m)
 {
     modules.push_back(m);
     m->app = application::this_app;
+    module_schedule_dirty = true;
 
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Module [%s] registered with application [%s]",
         m->name.c_str(), setup.name.c_str());
@@ -373,6 +723,7 @@ void application::unregister_module(std::shared_ptr<module> m)
 
     m->app = nullptr;
     modules.remove(m);
+    module_schedule_dirty = true;
 
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Module [%s] unregistered with application [%s]",
         m->name.c_str(), setup.name.c_str());
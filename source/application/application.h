@@ -2,11 +2,16 @@
 #include <SDL.h>
 #include <memory>
 #include <list>
+#include <vector>
+#include <functional>
 #include "application_setup.h"
 #include "../source/rendering/graphics.h"
+#include "../source/rendering/render_layer.h"
 #include "../source/core/input.h"
 #include "../source/core/module.h"
 #include "../tools/stopwatch.h"
+#include "../tools/job_system.h"
+#include "../tools/profiler.h"
 #include "../source/tools/framerate.h"
 #include "../source/assets/asset_management.h"
 
@@ -14,6 +19,7 @@ namespace isometric {
 
     class application
     {
+        friend class module;
     private:
         static std::shared_ptr<application> this_app; // Singleton
         bool initialized = false;
@@ -29,11 +35,31 @@ namespace isometric {
 
         SDL_Renderer* renderer = nullptr;
         SDL_Window* window = nullptr;
+        SDL_Surface* offscreen_surface = nullptr;   // What the software renderer draws to without a window
 
         std::shared_ptr<assets::asset_management> asset_manager = nullptr;
         std::shared_ptr<rendering::graphics> graphics = nullptr;
+        std::shared_ptr<tools::job_system> jobs = nullptr;
         std::list<std::shared_ptr<module>> modules;
 
+        enum module_phase { phase_update, phase_late_update, phase_fixed_update, phase_count };
+
+        // Modules in the order their updates start, each with the modules (by index) that have to finish first:
+        struct scheduled_module
+        {
+            std::shared_ptr<module> scheduled;
+            std::vector<size_t> dependencies;
+            const char* zone_names[phase_count];    // Profiler zone of each update function
+            bool run_inline = true;                 // Undeclared or conflicting, updated on the thread running updates
+        };
+
+        std::vector<scheduled_module> module_schedule;
+        bool module_schedule_dirty = true;
+
+        bool profile_capture_requested = false;
+        bool pipeline_started = false;              // The first pipelined frame has something to sync
+        SDL_threadID main_thread = 0;               // Thread that called start()
+
     public:
         virtual ~application();
 
@@ -53,11 +79,37 @@ namespace isometric {
         SDL_Rect get_viewport() const;
         SDL_FRect get_viewportf() const;
         SDL_Renderer* get_renderer() const;
+
+        /// <returns>
+        /// The surface frames are drawn to when the setup's rendering isn't render_mode::window, otherwise nullptr
+        /// </returns>
+        SDL_Surface* get_offscreen_surface() const { return offscreen_surface; }
         std::shared_ptr<rendering::graphics> get_graphics() const;
         std::shared_ptr<assets::asset_management> get_asset_manager() const;
+
+        /// <returns>
+        /// The job system, or nullptr once the application has shut down. It's kept until after modules are
+        /// unregistered and every job it has is run before and after that, so jobs may refer to modules.
+        /// </returns>
+        std::shared_ptr<tools::job_system> get_job_system() const;
+
         const tools::framerate& get_framerate() const { return current_fps; }
+        const tools::framerate& get_fixed_framerate() const { return current_fixed_fps; }
+
+        /// <returns>What was submitted to the renderer during the last presented frame</returns>
+        const rendering::render_counters& get_render_counters() const { return rendering::render_layer::get_last_frame(); }
+
+        /// <summary>
+        /// Start a new window for the frame time percentiles and stutter counts, such as after loading a level
+        /// </summary>
+        void reset_frame_statistics();
         bool is_initialized() const { return initialized; }
 
+        /// <summary>
+        /// Write the profiler's zones to the setup's profile_trace_path once the current frame has been presented
+        /// </summary>
+        void request_profile_capture() { profile_capture_requested = true; }
+
         static bool is_64bit();
 
     protected:
@@ -74,6 +126,20 @@ namespace isometric {
         /// </summary>
         virtual void on_fixed_update(double fixed_delta_time);
 
+        /// <summary>
+        /// Called on the main thread between updating a frame and drawing it, while nothing else is running. Copy the
+        /// state that on_render needs here: with pipelined rendering (see application_setup) the next frame is
+        /// updated on another thread while on_render draws. This must be called by derived classes or modules will
+        /// not have their sync functions called.
+        /// </summary>
+        virtual void on_sync();
+
+        /// <summary>
+        /// Draw the frame copied by the last on_sync, always called on the main thread. This must be called by
+        /// derived classes or modules will not have their render functions called.
+        /// </summary>
+        virtual void on_render(double delta_time);
+
         virtual bool on_event(const SDL_Event& e);
         virtual bool on_start() { return true; /* true to continue */ }
         virtual void on_shutdown() {}
@@ -82,6 +148,11 @@ namespace isometric {
 
         bool initialize();
         void try_call_fixed_update(double delta_time);
+        void run_frame(double delta_time);
+        void run_pipelined_frame(double delta_time);
+        void draw_frame(double delta_time);
+        void build_module_schedule();
+        void run_modules(module_phase phase, const std::function<void(module&)>& call);
         void broadcast_fps(double delta_time) const;
     };
 
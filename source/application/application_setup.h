@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include <SDL.h>
+#include "../enumerations/render_mode.h"
 
 namespace isometric {
 
@@ -16,10 +18,27 @@ namespace isometric {
         int screen_height = 720;
         bool vertical_sync = false;
 
+        // Offscreen and none don't open a window or need a display, for benchmarks, tests and servers. Modules and
+        // worlds behave the same in every mode, with none they just never get on_render calls:
+        render_mode rendering = render_mode::window;
+
         double fixed_update_fps = 50.0;
+        double target_fps = 60.0;           // Frames slower than this count as stutters in the frame statistics
 
         bool broadcast_fps = false;
         float broadcast_fps_elapsed = 5.0F;
+
+        // Update the next frame on a worker thread while the main thread draws the last one, see application::on_sync:
+        bool pipelined_rendering = false;
+
+        size_t worker_threads = 0;          // Job system worker threads, 0 for one less than the number of cores
+        bool pin_worker_threads = false;    // Keep each job system worker thread on its own core
+
+        // Record profiler zones from the start (see tools::profiler), pressing the capture key writes them to the
+        // trace file at the end of the frame:
+        bool profiling = false;
+        SDL_Scancode profile_capture_key = SDL_SCANCODE_F9;
+        std::string profile_trace_path = "profile_trace.json";
     };
 
 }
\ No newline at end of file
@@ -85,6 +85,10 @@ TTF_Font* font::get_font(int point_size) const
 
 void font::clear()
 {
+    // Text cached with these fonts has to be forgotten, another font could be opened at the same address:
+    auto app = application::get_app();
+    auto graphics = app ? app->get_graphics() : nullptr;
+
     for (auto& pair : fonts)
     {
         int point_size = pair.first;
@@ -92,6 +96,7 @@ void font::clear()
 
         if (sdl_font)
         {
+            if (graphics) graphics->get_text_cache().forget_font(sdl_font);
             TTF_CloseFont(sdl_font);
             sdl_font = nullptr;
         }
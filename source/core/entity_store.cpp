@@ -0,0 +1,186 @@
+#include "entity_store.h"
+
+using namespace isometric;
+
+entity entity_store::create(const SDL_FPoint& position, tile_image_index sprite, uint32_t entity_flags)
+{
+    uint32_t slot;
+
+    if (!free_slots.empty())
+    {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(slot_dense_indices.size());
+        slot_dense_indices.push_back(no_index);
+        slot_generations.push_back(0);
+    }
+
+    slot_dense_indices[slot] = static_cast<uint32_t>(positions.size());
+
+    positions.push_back(position);
+    velocities.push_back(SDL_FPoint{ 0.0f, 0.0f });
+    sprites.push_back(sprite);
+    flags.push_back(entity_flags | entity_moved);
+    objects.push_back(nullptr);
+    dense_slots.push_back(slot);
+
+    return entity{ slot, slot_generations[slot] };
+}
+
+void entity_store::destroy(const entity& handle)
+{
+    const uint32_t index = get_index(handle);
+    if (index == no_index) return;
+
+    // Move the last entity into the destroyed entity's place so the arrays stay packed:
+    const uint32_t last = static_cast<uint32_t>(positions.size() - 1);
+    if (index != last)
+    {
+        positions[index] = positions[last];
+        velocities[index] = velocities[last];
+        sprites[index] = sprites[last];
+        flags[index] = flags[last];
+        objects[index] = objects[last];
+        dense_slots[index] = dense_slots[last];
+
+        slot_dense_indices[dense_slots[index]] = index;
+    }
+
+    positions.pop_back();
+    velocities.pop_back();
+    sprites.pop_back();
+    flags.pop_back();
+    objects.pop_back();
+    dense_slots.pop_back();
+
+    // Bumping the generation invalidates every handle to the destroyed entity:
+    slot_dense_indices[handle.slot] = no_index;
+    slot_generations[handle.slot]++;
+    free_slots.push_back(handle.slot);
+}
+
+bool entity_store::is_alive(const entity& handle) const
+{
+    return get_index(handle) != no_index;
+}
+
+void entity_store::clear()
+{
+    for (uint32_t slot : dense_slots)
+    {
+        slot_dense_indices[slot] = no_index;
+        slot_generations[slot]++;
+        free_slots.push_back(slot);
+    }
+
+    positions.clear();
+    velocities.clear();
+    sprites.clear();
+    flags.clear();
+    objects.clear();
+    dense_slots.clear();
+}
+
+void entity_store::reserve(size_t capacity)
+{
+    positions.reserve(capacity);
+    velocities.reserve(capacity);
+    sprites.reserve(capacity);
+    flags.reserve(capacity);
+    objects.reserve(capacity);
+    dense_slots.reserve(capacity);
+}
+
+uint32_t entity_store::get_index(const entity& handle) const
+{
+    if (handle.slot >= slot_dense_indices.size() || slot_generations[handle.slot] != handle.generation)
+    {
+        return no_index;
+    }
+
+    return slot_dense_indices[handle.slot];
+}
+
+entity entity_store::get_entity(uint32_t index) const
+{
+    if (index >= dense_slots.size()) return entity();
+
+    const uint32_t slot = dense_slots[index];
+    return entity{ slot, slot_generations[slot] };
+}
+
+void entity_store::set_position(uint32_t index, const SDL_FPoint& position)
+{
+    positions[index] = position;
+    flags[index] |= entity_moved;
+}
+
+void entity_store::set_velocity(uint32_t index, const SDL_FPoint& velocity)
+{
+    velocities[index] = velocity;
+
+    if (velocity.x != 0.0f || velocity.y != 0.0f)
+    {
+        flags[index] |= entity_moving;
+    }
+    else
+    {
+        flags[index] &= ~entity_moving;
+    }
+}
+
+void entity_store::integrate(double delta_time)
+{
+    const float dt = static_cast<float>(delta_time);
+    const size_t count = positions.size();
+
+    SDL_FPoint* position = positions.data();
+    const SDL_FPoint* velocity = velocities.data();
+    uint32_t* entity_flag = flags.data();
+
+    // Entities without the moving flag have no velocity, so every entity is moved without a branch and only the flags
+    // depend on it:
+    for (size_t index = 0; index < count; index++)
+    {
+        position[index].x += velocity[index].x * dt;
+        position[index].y += velocity[index].y * dt;
+    }
+
+    for (size_t index = 0; index < count; index++)
+    {
+        entity_flag[index] |= (entity_flag[index] & entity_moving) << 1;
+    }
+
+    static_assert(entity_moved == entity_moving << 1, "integrate() turns entity_moving into entity_moved by shifting");
+}
+
+void entity_store::clear_moved()
+{
+    for (uint32_t& entity_flag : flags)
+    {
+        entity_flag &= ~entity_moved;
+    }
+}
+
+void entity_store::cull(const SDL_FRect& world_rect, std::vector<uint32_t>& results) const
+{
+    const float left = world_rect.x;
+    const float top = world_rect.y;
+    const float right = world_rect.x + world_rect.w;
+    const float bottom = world_rect.y + world_rect.h;
+    const uint32_t count = static_cast<uint32_t>(positions.size());
+
+    for (uint32_t index = 0; index < count; index++)
+    {
+        const SDL_FPoint& position = positions[index];
+
+        if ((flags[index] & entity_visible) && sprites[index] != empty_tile_image &&
+            position.x >= left && position.x < right && position.y >= top && position.y < bottom)
+        {
+            results.push_back(index);
+        }
+    }
+}
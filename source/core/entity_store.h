@@ -0,0 +1,135 @@
+#pragma once
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <SDL.h>
+#include "tile.h"
+
+namespace isometric {
+
+    class game_object;
+
+    enum entity_flags : uint32_t {
+        entity_visible = 1 << 0,    // Drawn by the world, if the entity has a sprite
+        entity_moving = 1 << 1,     // Moved by its velocity in entity_store::integrate
+        entity_moved = 1 << 2       // Set when the position changes, cleared by entity_store::clear_moved
+    };
+
+    /// <summary>
+    /// A handle to an entity in an entity_store. Handles stay valid while their entity exists no matter how the
+    /// store's arrays are rearranged, and a handle of a destroyed entity is never mistaken for a newer entity.
+    /// </summary>
+    struct entity
+    {
+        static constexpr uint32_t no_slot = std::numeric_limits<uint32_t>::max();
+
+        uint32_t slot = no_slot;
+        uint32_t generation = 0;
+
+        bool is_valid() const { return slot != no_slot; }
+        bool operator==(const entity& other) const { return slot == other.slot && generation == other.generation; }
+    };
+
+    /// <summary>
+    /// Stores entities as parallel arrays (a structure of arrays) rather than as objects, so that systems which only
+    /// need a couple of components (such as moving entities by their velocity, or culling by position) run through
+    /// tightly packed memory without any allocations, virtual calls or pointer chasing.
+    ///
+    /// The arrays are kept dense: destroying an entity moves the last entity into its place. Dense indices are only
+    /// stable until the next create() or destroy(), keep an entity handle to refer to an entity for longer.
+    /// </summary>
+    class entity_store
+    {
+    private:
+        // Components, all indexed by dense index:
+        std::vector<SDL_FPoint> positions;          // World pixels
+        std::vector<SDL_FPoint> velocities;         // World pixels per second
+        std::vector<tile_image_index> sprites;      // A tile map image, or empty_tile_image
+        std::vector<uint32_t> flags;                // entity_flags
+        std::vector<game_object*> objects;          // The game object using the entity, if there is one
+        std::vector<uint32_t> dense_slots;          // The slot of the entity at each dense index
+
+        // Slots map entity handles to dense indices:
+        std::vector<uint32_t> slot_dense_indices;
+        std::vector<uint32_t> slot_generations;
+        std::vector<uint32_t> free_slots;
+
+    public:
+        static constexpr uint32_t no_index = std::numeric_limits<uint32_t>::max();
+
+        entity create(
+            const SDL_FPoint& position,
+            tile_image_index sprite = empty_tile_image,
+            uint32_t entity_flags = entity_visible
+        );
+
+        void destroy(const entity& handle);
+        bool is_alive(const entity& handle) const;
+        void clear();
+
+        /// <summary>
+        /// Make room for a number of entities up front, so creating them doesn't reallocate the arrays
+        /// </summary>
+        void reserve(size_t capacity);
+
+        size_t size() const { return positions.size(); }
+
+        /// <returns>The entity's index into the component arrays, or no_index if it doesn't exist</returns>
+        uint32_t get_index(const entity& handle) const;
+
+        /// <returns>A handle for the entity at a dense index</returns>
+        entity get_entity(uint32_t index) const;
+
+        const SDL_FPoint& get_position(uint32_t index) const { return positions[index]; }
+        void set_position(uint32_t index, const SDL_FPoint& position);
+
+        const SDL_FPoint& get_velocity(uint32_t index) const { return velocities[index]; }
+        void set_velocity(uint32_t index, const SDL_FPoint& velocity);
+
+        tile_image_index get_sprite(uint32_t index) const { return sprites[index]; }
+        void set_sprite(uint32_t index, tile_image_index sprite) { sprites[index] = sprite; }
+
+        uint32_t get_flags(uint32_t index) const { return flags[index]; }
+        void set_flags(uint32_t index, uint32_t entity_flags) { flags[index] = entity_flags; }
+
+        game_object* get_object(uint32_t index) const { return objects[index]; }
+        void set_object(uint32_t index, game_object* obj) { objects[index] = obj; }
+
+        // Whole component arrays, for systems that process every entity at once:
+        const SDL_FPoint* get_positions() const { return positions.data(); }
+        const tile_image_index* get_sprites() const { return sprites.data(); }
+        const uint32_t* get_flags() const { return flags.data(); }
+
+        /// <summary>
+        /// Moves every entity with the entity_moving flag by its velocity, marking the entities that moved
+        /// </summary>
+        /// <param name="delta_time">Seconds since the last call</param>
+        void integrate(double delta_time);
+
+        /// <summary>
+        /// Clears the entity_moved flag of every entity
+        /// </summary>
+        void clear_moved();
+
+        /// <summary>
+        /// Finds the visible entities with a sprite whose position is inside a rect
+        /// </summary>
+        /// <param name="world_rect">The area to search, in world pixels</param>
+        /// <param name="results">The dense index of every entity found is added to this</param>
+        void cull(const SDL_FRect& world_rect, std::vector<uint32_t>& results) const;
+
+        /// <summary>
+        /// Calls f(uint32_t index) for every entity that has all of the given flags
+        /// </summary>
+        template<class F> void for_each(uint32_t required_flags, F&& f) const
+        {
+            const uint32_t count = static_cast<uint32_t>(flags.size());
+
+            for (uint32_t index = 0; index < count; index++)
+            {
+                if ((flags[index] & required_flags) == required_flags) f(index);
+            }
+        }
+    };
+
+}
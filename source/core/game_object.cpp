@@ -12,3 +12,41 @@ void game_object::setup_transform(std::shared_ptr<camera> camera, std::shared_pt
 {
     transform.reset(new isometric::transform(camera, map));
 }
+
+SDL_FPoint game_object::get_position() const
+{
+    if (!owner) return position;
+
+    return owner->entities.get_position(owner->entities.get_index(entity_handle));
+}
+
+void game_object::set_position(const SDL_FPoint& position)
+{
+    if (owner)
+    {
+        owner->object_moved(this, position);
+    }
+    else
+    {
+        this->position = position;
+    }
+}
+
+SDL_FPoint game_object::get_velocity() const
+{
+    if (!owner) return velocity;
+
+    return owner->entities.get_velocity(owner->entities.get_index(entity_handle));
+}
+
+void game_object::set_velocity(const SDL_FPoint& velocity)
+{
+    if (owner)
+    {
+        owner->entities.set_velocity(owner->entities.get_index(entity_handle), velocity);
+    }
+    else
+    {
+        this->velocity = velocity;
+    }
+}
@@ -2,11 +2,27 @@
 #include <SDL.h>
 #include <memory>
 #include "transform.h"
+#include "game_object_grid.h"
+#include "entity_store.h"
 
 namespace isometric {
 
+    class world;
+
     class game_object
     {
+        friend class world;
+        friend class game_object_grid;
+    private:
+        world* owner = nullptr;             // The world this object has been added to
+        entity entity_handle;               // Holds the position and velocity while the object is in a world
+        SDL_FPoint position = { 0.0f, 0.0f };
+        SDL_FPoint velocity = { 0.0f, 0.0f };
+
+        SDL_Point grid_tile = { 0, 0 };     // The tile position is on, kept up to date by the world
+        size_t grid_cell = game_object_grid::no_cell;
+        size_t grid_slot = 0;
+
     protected:
         std::unique_ptr<transform> transform = nullptr;
 
@@ -21,6 +37,33 @@ namespace isometric {
         /// <param name="map"></param>
         void setup_transform(std::shared_ptr<camera> camera, std::shared_ptr<tile_map> map);
 
+        /// <returns>The position of the object in world pixels</returns>
+        SDL_FPoint get_position() const;
+
+        /// <summary>
+        /// Move the object, keeping the world's index of where objects are up to date
+        /// </summary>
+        /// <param name="position">The new position in world pixels</param>
+        void set_position(const SDL_FPoint& position);
+
+        /// <returns>The velocity of the object in world pixels per second</returns>
+        SDL_FPoint get_velocity() const;
+
+        /// <summary>
+        /// Set how fast the object moves, the world moves it along with its other entities every update
+        /// </summary>
+        /// <param name="velocity">The new velocity in world pixels per second</param>
+        void set_velocity(const SDL_FPoint& velocity);
+
+        /// <returns>The tile the object's position is on, once it has been added to a world</returns>
+        const SDL_Point& get_tile() const { return grid_tile; }
+
+        /// <summary>
+        /// Called by world::sync() for objects that are about to be drawn, copy anything on_render needs that can
+        /// change while updating, as on_render may run at the same time as the next update
+        /// </summary>
+        virtual void on_sync() {}
+
         virtual void on_render(SDL_Renderer* renderer, double delta_time) = 0;
     };
 
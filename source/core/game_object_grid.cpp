@@ -0,0 +1,66 @@
+#include "game_object_grid.h"
+#include "game_object.h"
+#include <algorithm>
+
+using namespace isometric;
+
+void game_object_grid::create(unsigned map_width, unsigned map_height)
+{
+    cells_wide = std::max((map_width + cell_size - 1) >> cell_shift, 1u);
+    cells_high = std::max((map_height + cell_size - 1) >> cell_shift, 1u);
+
+    cells.clear();
+    cells.resize(static_cast<size_t>(cells_wide) * cells_high);
+    object_count = 0;
+}
+
+size_t game_object_grid::get_cell_index(const SDL_Point& tile) const
+{
+    // Tiles outside of the map are kept in the cells on its edges:
+    unsigned cell_x = std::min(static_cast<unsigned>(std::max(tile.x, 0)) >> cell_shift, cells_wide - 1);
+    unsigned cell_y = std::min(static_cast<unsigned>(std::max(tile.y, 0)) >> cell_shift, cells_high - 1);
+
+    return static_cast<size_t>(cell_y) * cells_wide + cell_x;
+}
+
+void game_object_grid::insert(game_object* obj, const SDL_Point& tile)
+{
+    if (!obj || cells.empty() || obj->grid_cell != no_cell) return;
+
+    auto& cell = cells[get_cell_index(tile)];
+
+    obj->grid_tile = tile;
+    obj->grid_cell = get_cell_index(tile);
+    obj->grid_slot = cell.size();
+    cell.push_back(obj);
+
+    object_count++;
+}
+
+void game_object_grid::move(game_object* obj, const SDL_Point& tile)
+{
+    if (!obj || obj->grid_cell == no_cell) return;
+
+    obj->grid_tile = tile;
+    if (get_cell_index(tile) == obj->grid_cell) return;
+
+    remove(obj);
+    insert(obj, tile);
+}
+
+void game_object_grid::remove(game_object* obj)
+{
+    if (!obj || obj->grid_cell == no_cell) return;
+
+    // Swap the last object of the cell into the removed object's slot so removing doesn't shift the rest:
+    auto& cell = cells[obj->grid_cell];
+    game_object* last = cell.back();
+    cell[obj->grid_slot] = last;
+    last->grid_slot = obj->grid_slot;
+    cell.pop_back();
+
+    obj->grid_cell = no_cell;
+    obj->grid_slot = 0;
+
+    object_count--;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <SDL.h>
+
+namespace isometric {
+
+    class game_object;
+
+    /// <summary>
+    /// A uniform grid of game objects keyed by the tile each object is on, one cell per tile map chunk. Inserting,
+    /// moving and removing an object is O(1) and a region query only looks at the objects in the cells overlapping
+    /// the region, so the cost of a query doesn't grow with the number of objects elsewhere in the world.
+    ///
+    /// The grid doesn't own its objects, objects must be removed before they are destroyed.
+    /// </summary>
+    class game_object_grid
+    {
+    public:
+        static constexpr unsigned cell_shift = 5;
+        static constexpr unsigned cell_size = 1 << cell_shift;    // Tiles per cell row and column
+        static constexpr size_t no_cell = std::numeric_limits<size_t>::max();
+
+    private:
+        unsigned cells_wide = 0;
+        unsigned cells_high = 0;
+        std::vector<std::vector<game_object*>> cells;
+        size_t object_count = 0;
+
+        size_t get_cell_index(const SDL_Point& tile) const;
+
+    public:
+        /// <summary>
+        /// Setup the grid for a map of the given size in tiles, any objects in the grid are forgotten
+        /// </summary>
+        void create(unsigned map_width, unsigned map_height);
+
+        void insert(game_object* obj, const SDL_Point& tile);
+
+        /// <summary>
+        /// Update the tile an object is on, this only touches the grid if the object moved to another cell
+        /// </summary>
+        void move(game_object* obj, const SDL_Point& tile);
+
+        void remove(game_object* obj);
+
+        size_t get_object_count() const { return object_count; }
+
+        /// <summary>
+        /// Calls f(game_object*) for every object in the cells that overlap a rect of tiles. Objects near the rect
+        /// are included as well, callers filter the objects themselves if they need an exact result.
+        /// </summary>
+        /// <param name="tile_rect">The tiles to look for objects in, it may extend outside of the map</param>
+        template<class F> void for_each_in_tiles(const SDL_Rect& tile_rect, F&& f) const
+        {
+            if (cells.empty() || tile_rect.w <= 0 || tile_rect.h <= 0) return;
+
+            // Tiles outside of the map are kept in the cells on its edges:
+            auto to_cell = [](int tile, unsigned cells_along) {
+                return std::min(static_cast<unsigned>(std::max(tile, 0)) >> cell_shift, cells_along - 1);
+            };
+
+            const unsigned first_cell_x = to_cell(tile_rect.x, cells_wide);
+            const unsigned last_cell_x = to_cell(tile_rect.x + tile_rect.w - 1, cells_wide);
+            const unsigned first_cell_y = to_cell(tile_rect.y, cells_high);
+            const unsigned last_cell_y = to_cell(tile_rect.y + tile_rect.h - 1, cells_high);
+
+            for (unsigned cell_y = first_cell_y; cell_y <= last_cell_y; cell_y++)
+            {
+                for (unsigned cell_x = first_cell_x; cell_x <= last_cell_x; cell_x++)
+                {
+                    for (game_object* obj : cells[static_cast<size_t>(cell_y) * cells_wide + cell_x])
+                    {
+                        f(obj);
+                    }
+                }
+            }
+        }
+    };
+
+}
@@ -1,5 +1,6 @@
 #include "module.h"
 #include "../source/application/application.h"
+#include <algorithm>
 
 using namespace::isometric;
 
@@ -29,4 +30,48 @@ bool module::set_enabled(bool enable)
     enabled = enable;
 
     return original_enabled_value;
+}
+
+void module::declare_access(std::initializer_list<std::string> reads, std::initializer_list<std::string> writes)
+{
+    access_declared = true;
+    read_access.insert(read_access.end(), reads.begin(), reads.end());
+    write_access.insert(write_access.end(), writes.begin(), writes.end());
+
+    if (app) app->module_schedule_dirty = true;
+}
+
+void module::run_after(std::shared_ptr<module> other)
+{
+    run_after_modules.push_back(other);
+
+    if (app) app->module_schedule_dirty = true;
+}
+
+void module::run_before(std::shared_ptr<module> other)
+{
+    run_before_modules.push_back(other);
+
+    if (app) app->module_schedule_dirty = true;
+}
+
+bool module::conflicts_with(const module& other) const
+{
+    if (!access_declared || !other.access_declared) return true;
+
+    auto writes_to = [](const module& writer, const std::vector<std::string>& resources) {
+        return std::any_of(resources.begin(), resources.end(), [&writer](const std::string& resource) {
+            return std::find(writer.write_access.begin(), writer.write_access.end(), resource) !=
+                writer.write_access.end();
+        });
+    };
+
+    return
+        writes_to(*this, other.read_access) || writes_to(*this, other.write_access) ||
+        writes_to(other, read_access);
+}
+
+isometric::tools::job_system& module::get_job_system() const
+{
+    return *application::get_app()->get_job_system();
 }
\ No newline at end of file
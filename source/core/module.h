@@ -2,8 +2,14 @@
 #include <SDL.h>
 #include <string>
 #include <memory>
+#include <vector>
+#include <initializer_list>
 #include <type_traits>
 
+namespace isometric::tools {
+    class job_system;
+}
+
 namespace isometric {
 
     class application;
@@ -17,6 +23,15 @@ namespace isometric {
         std::string name;
         bool enabled = true;
 
+        // What the module's updates touch, used by the application to run modules that don't interact at once:
+        bool access_declared = false;
+        std::vector<std::string> read_access;
+        std::vector<std::string> write_access;
+        std::vector<std::weak_ptr<module>> run_after_modules;
+        std::vector<std::weak_ptr<module>> run_before_modules;
+
+        bool conflicts_with(const module& other) const;
+
     public:
         virtual ~module();
 
@@ -26,6 +41,25 @@ namespace isometric {
         bool is_enabled() const { return enabled; }
         bool set_enabled(bool enable = true);
 
+        /// <summary>
+        /// Declare the shared state the module's update functions read and write, named however suits the game (such
+        /// as "camera" or "input"). Only modules that share written state with no other module are updated on the job
+        /// system's workers, modules that never declare their access or that conflict with another module are updated
+        /// one at a time on the thread running the updates.
+        /// Declaring no reads or writes at all means the module's updates don't touch anything shared.
+        /// </summary>
+        void declare_access(std::initializer_list<std::string> reads, std::initializer_list<std::string> writes = {});
+
+        /// <summary>
+        /// Make the module's update functions always run after another module's, whatever they access
+        /// </summary>
+        void run_after(std::shared_ptr<module> other);
+
+        /// <summary>
+        /// Make the module's update functions always run before another module's, whatever they access
+        /// </summary>
+        void run_before(std::shared_ptr<module> other);
+
     protected:
         module();
 
@@ -35,6 +69,21 @@ namespace isometric {
         virtual void on_update(double delta_time) {}
         virtual void on_late_update(double delta_time) {}
         virtual void on_fixed_update(double fixed_delta_time) {}
+
+        /// <summary>
+        /// Called on the main thread while nothing is updating or rendering, copy anything on_render needs here
+        /// </summary>
+        virtual void on_sync() {}
+
+        /// <summary>
+        /// Draw using what was copied in on_sync, with pipelined rendering this runs while the next frame updates
+        /// </summary>
+        virtual void on_render(double delta_time) {}
+
+        /// <summary>
+        /// The application's job system, for running a module's work in parallel
+        /// </summary>
+        tools::job_system& get_job_system() const;
     };
 
     template<class T>
@@ -0,0 +1,57 @@
+#include "tile.h"
+#include "tile_map.h"
+
+using namespace isometric;
+
+bool tile::is_empty() const
+{
+    if (!map) return true;
+
+    for (unsigned layer_id = 0; layer_id < map->get_layer_count(); layer_id++)
+    {
+        if (map->has_image(x, y, layer_id)) return false;
+    }
+
+    return true;
+}
+
+bool tile::is_passable() const
+{
+    return map && (map->get_tile_flags(x, y) & tile_flag_passable);
+}
+
+void tile::set_passable(bool passable)
+{
+    if (!map) return;
+
+    uint8_t flags = map->get_tile_flags(x, y);
+    map->set_tile_flags(x, y, passable ? flags | tile_flag_passable : flags & ~tile_flag_passable);
+}
+
+bool tile::is_enabled() const
+{
+    return map && (map->get_tile_flags(x, y) & tile_flag_enabled);
+}
+
+void tile::set_enabled(bool enabled)
+{
+    if (!map) return;
+
+    uint8_t flags = map->get_tile_flags(x, y);
+    map->set_tile_flags(x, y, enabled ? flags | tile_flag_enabled : flags & ~tile_flag_enabled);
+}
+
+bool tile::has_image(unsigned layer_id) const
+{
+    return map && map->has_image(x, y, layer_id);
+}
+
+void tile::set_image_id(unsigned layer_id, unsigned image_id)
+{
+    if (map) map->set_image_id(x, y, layer_id, image_id);
+}
+
+unsigned tile::get_image_id(unsigned layer_id) const
+{
+    return map ? map->get_image_id(x, y, layer_id) : 0;
+}
@@ -1,63 +1,67 @@
 #pragma once
-#include <unordered_map>
+#include <cstdint>
+#include <limits>
 
 namespace isometric {
 
+    class tile_map;
+
+    /// <summary>
+    /// Compact image id as it is stored in a tile map's layer arrays
+    /// </summary>
+    using tile_image_index = uint16_t;
+
+    /// <summary>
+    /// Stored in a layer array when a tile has no image in that layer
+    /// </summary>
+    constexpr tile_image_index empty_tile_image = std::numeric_limits<tile_image_index>::max();
+
+    enum tile_flags : uint8_t {
+        tile_flag_none = 0,
+        tile_flag_enabled = 1 << 0,
+        tile_flag_passable = 1 << 1,
+
+        tile_flags_default = tile_flag_enabled | tile_flag_passable
+    };
+
+    /// <summary>
+    /// A lightweight view of a single tile in a tile map. The tile data itself lives in the tile map's per-layer
+    /// arrays, so a tile is only valid for as long as the map it was obtained from.
+    /// </summary>
     class tile
     {
     private:
-        bool enabled = true;
-        bool passable = true;
-        bool empty = true;
-        std::unordered_map<unsigned, unsigned> image_ids;
+        tile_map* map = nullptr;
+        unsigned x = 0;
+        unsigned y = 0;
 
     public:
-        tile(bool passable = true, bool enabled = true) : passable(passable), enabled(enabled),
-            empty(false)
-        {}
+        tile() {}
+        tile(tile_map* map, unsigned x, unsigned y) : map(map), x(x), y(y) {}
 
-        bool is_empty() const
+        /// <returns>True if this tile refers to a tile within a map</returns>
+        bool is_valid() const
         {
-            return empty;
+            return map != nullptr;
         }
 
-        bool is_passable() const
-        {
-            return passable;
-        }
+        explicit operator bool() const { return is_valid(); }
 
-        bool is_enabled() const
-        {
-            return enabled;
-        }
+        unsigned get_x() const { return x; }
+        unsigned get_y() const { return y; }
 
-        bool has_image(unsigned layer_id) const
-        {
-            return image_ids.contains(layer_id);
-        }
+        /// <returns>True if the tile has no image in any layer</returns>
+        bool is_empty() const;
 
-        void set_image_id(unsigned layer_id, unsigned image_id)
-        {
-            image_ids[layer_id] = image_id;
-            this->empty = false;
-        }
+        bool is_passable() const;
+        void set_passable(bool passable = true);
 
-        unsigned get_image_id(unsigned layer_id) const
-        {
-            if (image_ids.contains(layer_id))
-            {
-                return image_ids.at(layer_id);
-            }
-            else
-            {
-                return 0;
-            }
-        }
+        bool is_enabled() const;
+        void set_enabled(bool enabled = true);
 
-        const std::unordered_map<unsigned, unsigned>& get_image_ids() const
-        {
-            return image_ids;
-        }
+        bool has_image(unsigned layer_id) const;
+        void set_image_id(unsigned layer_id, unsigned image_id);
+        unsigned get_image_id(unsigned layer_id) const;
     };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,413 @@
+#include "tile_chunk_cache.h"
+#include "../rendering/render_layer.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace isometric;
+
+tile_chunk_cache::tile_chunk_cache(unsigned max_chunks) : max_chunks(max_chunks)
+{
+
+}
+
+bool tile_chunk_cache::setup_renderer(SDL_Renderer* renderer)
+{
+    if (this->renderer == renderer) return enabled;
+
+    clear();
+    this->renderer = renderer;
+    enabled = renderer && SDL_RenderTargetSupported(renderer);
+
+    if (!enabled)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Render targets aren't supported, tile chunks won't be cached");
+    }
+
+    SDL_RendererInfo info{};
+    if (renderer && SDL_GetRendererInfo(renderer, &info) == 0)
+    {
+        max_texture_width = info.max_texture_width;
+        max_texture_height = info.max_texture_height;
+    }
+    else
+    {
+        max_texture_width = 0;
+        max_texture_height = 0;
+    }
+
+    // Tiles drawn with alpha blending onto a transparent texture leave it with premultiplied alpha, so chunks are
+    // drawn to the screen with a premultiplied blend mode (if the renderer supports it, otherwise regular blending
+    // is close enough, only the partially transparent edges of tiles on the edges of the map are slightly darker):
+    composite_blend_mode = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD
+    );
+
+    return enabled;
+}
+
+bool tile_chunk_cache::setup_chunk_tiles(const tile_map& map)
+{
+    const SDL_FRect& image_bounds = map.get_image_bounds();
+    const float tile_width = static_cast<float>(map.get_tile_width());
+    const float half_tile_height = map.get_tile_height() / 2.0f;
+
+    // The largest chunk texture is that of a chunk on every edge of the map, which is widened by how far images reach
+    // past the tile on every side. Chunks are halved until that fits, they always have an even number of rows so that
+    // their first tile is on an even row:
+    auto fits = [&](unsigned tiles) {
+        const float width = std::ceil((tiles - 1) * tile_width + tile_width / 2.0f + image_bounds.x + image_bounds.w) -
+            std::floor(image_bounds.x);
+        const float height = std::ceil((tiles - 1) * half_tile_height + image_bounds.y + image_bounds.h) -
+            std::floor(image_bounds.y);
+
+        return (max_texture_width <= 0 || width <= max_texture_width) &&
+            (max_texture_height <= 0 || height <= max_texture_height);
+    };
+
+    unsigned tiles = tile_map::chunk_size;
+    while (tiles > 2 && !fits(tiles))
+    {
+        tiles /= 2;
+    }
+
+    if (!fits(tiles))
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "The renderer's largest texture (%d x %d) is too small for tile "
+            "chunks, tile chunks won't be cached", max_texture_width, max_texture_height);
+
+        clear();
+        enabled = false;
+        return false;
+    }
+
+    if (tiles != chunk_tiles)
+    {
+        SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Tile chunks are %u x %u tiles to fit a %d x %d texture limit",
+            tiles, tiles, max_texture_width, max_texture_height);
+
+        clear();
+        chunk_tiles = tiles;
+    }
+
+    return true;
+}
+
+bool tile_chunk_cache::begin_frame(SDL_Renderer* renderer, const tile_map& map)
+{
+    frame++;
+    redrawn_chunk_count = 0;
+
+    if (!setup_renderer(renderer)) return false;
+    return setup_chunk_tiles(map);
+}
+
+unsigned tile_chunk_cache::get_chunks_wide(const tile_map& map) const
+{
+    return (map.get_map_width() + chunk_tiles - 1) / chunk_tiles;
+}
+
+unsigned tile_chunk_cache::get_chunks_high(const tile_map& map) const
+{
+    return (map.get_map_height() + chunk_tiles - 1) / chunk_tiles;
+}
+
+SDL_FRect tile_chunk_cache::get_chunk_rect(const tile_map& map, unsigned chunk_x, unsigned chunk_y) const
+{
+    // Relative to the first tile of a chunk (which is always on an even row), a chunk covers chunk_tiles tiles across
+    // and chunk_tiles half tiles down, which is where the next chunk starts:
+    const SDL_FRect& image_bounds = map.get_image_bounds();
+    const float tile_width = static_cast<float>(map.get_tile_width());
+    const float half_tile_height = map.get_tile_height() / 2.0f;
+
+    float left = 0.0f;
+    float top = 0.0f;
+    float right = chunk_tiles * tile_width;
+    float bottom = chunk_tiles * half_tile_height;
+
+    // There are no chunks past the edges of the map, so chunks on the edges also cover whatever their tiles draw
+    // outside of it. The last tile of a row is on an odd row, half a tile to the right, and every tile can draw
+    // anywhere within the map's image bounds:
+    if (chunk_x == 0) left = std::floor(image_bounds.x);
+    if (chunk_y == 0) top = std::floor(image_bounds.y);
+
+    if (chunk_x + 1 >= get_chunks_wide(map))
+    {
+        const unsigned last_x = map.get_map_width() - 1 - chunk_x * chunk_tiles;
+        right = std::ceil(last_x * tile_width + tile_width / 2.0f + image_bounds.x + image_bounds.w);
+    }
+
+    if (chunk_y + 1 >= get_chunks_high(map))
+    {
+        const unsigned last_y = map.get_map_height() - 1 - chunk_y * chunk_tiles;
+        bottom = std::ceil(last_y * half_tile_height + image_bounds.y + image_bounds.h);
+    }
+
+    return SDL_FRect{ left, top, right - left, bottom - top };
+}
+
+SDL_Rect tile_chunk_cache::get_chunk_tile_range(const tile_map& map, unsigned chunk_x, unsigned chunk_y) const
+{
+    // Every tile whose image can reach into the chunk's rectangle, including tiles of the chunks around it:
+    const SDL_FRect& image_bounds = map.get_image_bounds();
+    const float tile_width = static_cast<float>(map.get_tile_width());
+    const float half_tile_height = map.get_tile_height() / 2.0f;
+    const SDL_FRect chunk_rect = get_chunk_rect(map, chunk_x, chunk_y);
+
+    // The chunk's rectangle, relative to the first tile of the map:
+    const float rect_left = chunk_x * chunk_tiles * tile_width + chunk_rect.x;
+    const float rect_top = chunk_y * chunk_tiles * half_tile_height + chunk_rect.y;
+    const float rect_right = rect_left + chunk_rect.w;
+    const float rect_bottom = rect_top + chunk_rect.h;
+
+    const int first_x = static_cast<int>(
+        std::floor((rect_left - tile_width / 2.0f - image_bounds.x - image_bounds.w) / tile_width)
+    );
+    const int end_x = static_cast<int>(std::ceil((rect_right - image_bounds.x) / tile_width));
+    const int first_y = static_cast<int>(std::floor((rect_top - image_bounds.y - image_bounds.h) / half_tile_height));
+    const int end_y = static_cast<int>(std::ceil((rect_bottom - image_bounds.y) / half_tile_height));
+
+    const int clamped_first_x = std::max(first_x, 0);
+    const int clamped_first_y = std::max(first_y, 0);
+    const int clamped_end_x = std::min(end_x, static_cast<int>(map.get_map_width()));
+    const int clamped_end_y = std::min(end_y, static_cast<int>(map.get_map_height()));
+
+    return SDL_Rect{
+        clamped_first_x, clamped_first_y,
+        std::max(clamped_end_x - clamped_first_x, 0), std::max(clamped_end_y - clamped_first_y, 0)
+    };
+}
+
+uint64_t tile_chunk_cache::get_chunk_revision(const tile_map& map, const SDL_Rect& tile_range) const
+{
+    if (tile_range.w <= 0 || tile_range.h <= 0) return 0;
+
+    // Revisions only ever go up, so their sum changes whenever any of them do:
+    const unsigned first_map_chunk_x = static_cast<unsigned>(tile_range.x) / tile_map::chunk_size;
+    const unsigned first_map_chunk_y = static_cast<unsigned>(tile_range.y) / tile_map::chunk_size;
+    const unsigned last_map_chunk_x = static_cast<unsigned>(tile_range.x + tile_range.w - 1) / tile_map::chunk_size;
+    const unsigned last_map_chunk_y = static_cast<unsigned>(tile_range.y + tile_range.h - 1) / tile_map::chunk_size;
+
+    uint64_t revision = 0;
+    for (unsigned map_chunk_y = first_map_chunk_y; map_chunk_y <= last_map_chunk_y; map_chunk_y++)
+    {
+        for (unsigned map_chunk_x = first_map_chunk_x; map_chunk_x <= last_map_chunk_x; map_chunk_x++)
+        {
+            revision += map.get_static_chunk_revision(map_chunk_x, map_chunk_y);
+        }
+    }
+
+    return revision;
+}
+
+SDL_Texture* tile_chunk_cache::take_texture(int width, int height)
+{
+    // Reuse the texture of the least recently used chunk, as long as it wasn't used this frame:
+    if (chunks.size() >= max_chunks)
+    {
+        auto oldest = chunks.end();
+        for (auto iter = chunks.begin(); iter != chunks.end(); iter++)
+        {
+            if (iter->second.last_used_frame == frame) continue;
+            if (oldest == chunks.end() || iter->second.last_used_frame < oldest->second.last_used_frame)
+            {
+                oldest = iter;
+            }
+        }
+
+        if (oldest != chunks.end())
+        {
+            SDL_Texture* texture = oldest->second.texture;
+            bool same_size = oldest->second.width == width && oldest->second.height == height;
+            chunks.erase(oldest);
+
+            if (same_size) return texture;
+            SDL_DestroyTexture(texture);
+        }
+    }
+
+    SDL_Texture* texture = SDL_CreateTexture(
+        renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height
+    );
+
+    if (!texture)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to create a %d x %d tile chunk texture, tile chunks won't "
+            "be cached: %s", width, height, SDL_GetError());
+        return nullptr;
+    }
+
+    if (rendering::render_layer::set_blend_mode(texture, composite_blend_mode) != 0)
+    {
+        rendering::render_layer::set_blend_mode(texture, SDL_BLENDMODE_BLEND);
+    }
+
+    return texture;
+}
+
+SDL_Texture* tile_chunk_cache::get_chunk(
+    SDL_Renderer* renderer,
+    const tile_map& map,
+    unsigned chunk_x, unsigned chunk_y,
+    unsigned layer_count
+)
+{
+    if (!setup_renderer(renderer)) return nullptr;
+    if (chunk_x >= get_chunks_wide(map) || chunk_y >= get_chunks_high(map)) return nullptr;
+
+    const size_t chunk_index = static_cast<size_t>(chunk_y) * get_chunks_wide(map) + chunk_x;
+    const SDL_Rect tile_range = get_chunk_tile_range(map, chunk_x, chunk_y);
+    const uint64_t chunk_revision = get_chunk_revision(map, tile_range);
+    const uint32_t static_revision = map.get_static_revision();
+
+    auto iter = chunks.find(chunk_index);
+    if (iter != chunks.end())
+    {
+        cached_chunk& chunk = iter->second;
+        chunk.last_used_frame = frame;
+
+        if (chunk.layer_count == layer_count &&
+            chunk.chunk_revision == chunk_revision &&
+            chunk.static_revision == static_revision)
+        {
+            return chunk.texture;
+        }
+    }
+
+    const SDL_FRect chunk_rect = get_chunk_rect(map, chunk_x, chunk_y);
+    const int width = static_cast<int>(chunk_rect.w);
+    const int height = static_cast<int>(chunk_rect.h);
+
+    // The chunk needs to be drawn, find a texture of the right size for it if it doesn't have one:
+    if (iter == chunks.end() || iter->second.width != width || iter->second.height != height)
+    {
+        if (iter != chunks.end())
+        {
+            SDL_DestroyTexture(iter->second.texture);
+            chunks.erase(iter);
+        }
+
+        SDL_Texture* texture = take_texture(width, height);
+        if (!texture)
+        {
+            clear();
+            enabled = false;
+            return nullptr;
+        }
+
+        iter = chunks.emplace(chunk_index, cached_chunk{ texture, width, height }).first;
+    }
+
+    cached_chunk& chunk = iter->second;
+    chunk.layer_count = layer_count;
+    chunk.chunk_revision = chunk_revision;
+    chunk.static_revision = static_revision;
+    chunk.last_used_frame = frame;
+
+    SDL_Texture* previous_target = SDL_GetRenderTarget(renderer);
+    rendering::render_layer::set_target(renderer, chunk.texture);
+
+    const SDL_Color draw_color = rendering::render_layer::get_draw_color(renderer);
+    rendering::render_layer::set_draw_color(renderer, 0, 0, 0, 0);
+    rendering::render_layer::clear(renderer);
+    rendering::render_layer::set_draw_color(renderer, draw_color.r, draw_color.g, draw_color.b, draw_color.a);
+
+    draw_chunk(map, chunk_x, chunk_y, chunk_rect, tile_range, layer_count);
+    chunk_batch.submit(renderer);
+
+    rendering::render_layer::set_target(renderer, previous_target);
+    redrawn_chunk_count++;
+
+    return chunk.texture;
+}
+
+void tile_chunk_cache::draw_chunk(
+    const tile_map& map,
+    unsigned chunk_x, unsigned chunk_y,
+    const SDL_FRect& chunk_rect,
+    const SDL_Rect& tile_range,
+    unsigned layer_count
+)
+{
+    const float tile_width = static_cast<float>(map.get_tile_width());
+    const float half_tile_height = map.get_tile_height() / 2.0f;
+
+    // Tiles are placed relative to the first tile of the chunk, tiles of the chunks around it are at negative or
+    // past the end positions and only the part of them that is within the chunk's rectangle lands in the texture:
+    const int first_x = static_cast<int>(chunk_x * chunk_tiles);
+    const int first_y = static_cast<int>(chunk_y * chunk_tiles);
+
+    const unsigned range_end_x = static_cast<unsigned>(tile_range.x + tile_range.w);
+    const unsigned range_end_y = static_cast<unsigned>(tile_range.y + tile_range.h);
+
+    layer_runs.resize(layer_count);
+
+    for (unsigned map_y = static_cast<unsigned>(tile_range.y); map_y < range_end_y; map_y++)
+    {
+        // Odd rows are staggered half a tile to the right of even rows:
+        const float row_x = (map_y % 2 == 0 ? 0.0f : tile_width / 2.0f) - chunk_rect.x;
+        const float row_y = (static_cast<int>(map_y) - first_y) * half_tile_height - chunk_rect.y;
+
+        // The row can cross map chunks, within each every layer's image indices are contiguous:
+        const unsigned range_first_x = static_cast<unsigned>(tile_range.x);
+        for (unsigned run_x = range_first_x, run_end_x = 0; run_x < range_end_x; run_x = run_end_x)
+        {
+            run_end_x = std::min((run_x | (tile_map::chunk_size - 1)) + 1, range_end_x);
+
+            for (unsigned layer_id = 0; layer_id < layer_count; layer_id++)
+            {
+                layer_runs[layer_id] = map.get_layer(layer_id).visible
+                    ? map.get_layer_run(layer_id, run_x, map_y)
+                    : nullptr;
+            }
+
+            for (unsigned map_x = run_x; map_x < run_end_x; map_x++)
+            {
+                const float tile_x = row_x + (static_cast<int>(map_x) - first_x) * tile_width;
+
+                for (unsigned layer_id = 0; layer_id < layer_count; layer_id++)
+                {
+                    const tile_layer& layer = map.get_layer(layer_id);
+                    if (!layer.visible) continue;
+
+                    tile_image_index image_index =
+                        layer_runs[layer_id]
+                        ? layer_runs[layer_id][map_x - run_x]
+                        : empty_tile_image;
+
+                    if (image_index == empty_tile_image)
+                    {
+                        image_index =
+                            static_cast<tile_image_index>(map.get_layer_default_image(map_x, map_y, layer_id));
+                        if (image_index == empty_tile_image) continue;
+                    }
+
+                    const tile_image_draw* image_draw = map.get_image_draw(image_index);
+                    if (!image_draw) continue;
+
+                    SDL_FRect dest_rect = image_draw->dest_rect;
+                    dest_rect.x += tile_x;
+                    dest_rect.y += row_y;
+
+                    chunk_batch.add_quad(
+                        image_draw->texture,
+                        image_draw->source_rect,
+                        image_draw->texture_size,
+                        dest_rect,
+                        SDL_Color{ 255, 255, 255, layer.opacity }
+                    );
+                }
+            }
+        }
+    }
+}
+
+void tile_chunk_cache::clear()
+{
+    for (auto& [chunk_index, chunk] : chunks)
+    {
+        if (chunk.texture) SDL_DestroyTexture(chunk.texture);
+    }
+
+    chunks.clear();
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include <SDL.h>
+#include "tile_map.h"
+#include "../rendering/geometry_batch.h"
+
+namespace isometric {
+
+    /// <summary>
+    /// Keeps pre-rendered textures of the static layers of a tile map, one render target texture per chunk, so that a
+    /// screen full of unchanging terrain is drawn with a handful of chunk quads instead of one quad per tile and layer.
+    ///
+    /// A chunk's texture covers its own rectangle of the map and chunks never overlap, so the order they're drawn in
+    /// doesn't matter. Tiles of neighbouring chunks whose images reach into the rectangle are drawn into it as well,
+    /// in row order, so images taller or wider than a tile overlap correctly across chunk seams. Chunks are
+    /// tile_map::chunk_size tiles across, or smaller if the renderer can't create textures that large.
+    ///
+    /// A chunk's texture is only redrawn when the map reports that a chunk it draws tiles from changed (see
+    /// tile_map::get_static_chunk_revision). The least recently used textures are reused once max_chunks are cached.
+    ///
+    /// Textures belong to the renderer they were created with and are freed along with it, clear() frees them sooner.
+    /// </summary>
+    class tile_chunk_cache
+    {
+    public:
+        static constexpr unsigned default_max_chunks = 32;
+
+    private:
+        struct cached_chunk
+        {
+            SDL_Texture* texture = nullptr;
+            int width = 0;
+            int height = 0;
+            unsigned layer_count = 0;
+            uint64_t chunk_revision = 0;    // Sum of the revisions of the map chunks the texture has tiles from
+            uint32_t static_revision = 0;
+            uint64_t last_used_frame = 0;
+        };
+
+        std::unordered_map<size_t, cached_chunk> chunks;    // By chunk index (chunk_y * get_chunks_wide() + chunk_x)
+        unsigned max_chunks = default_max_chunks;
+        uint64_t frame = 0;
+        bool enabled = true;
+        SDL_Renderer* renderer = nullptr;
+        SDL_BlendMode composite_blend_mode = SDL_BLENDMODE_BLEND;
+        int max_texture_width = 0;                          // 0 if the renderer doesn't have a limit
+        int max_texture_height = 0;
+        unsigned chunk_tiles = tile_map::chunk_size;        // Tiles per chunk row and column
+
+        rendering::geometry_batch chunk_batch;
+        std::vector<const tile_image_index*> layer_runs;
+        unsigned redrawn_chunk_count = 0;
+
+        bool setup_renderer(SDL_Renderer* renderer);
+        bool setup_chunk_tiles(const tile_map& map);
+        SDL_Rect get_chunk_tile_range(const tile_map& map, unsigned chunk_x, unsigned chunk_y) const;
+        uint64_t get_chunk_revision(const tile_map& map, const SDL_Rect& tile_range) const;
+        SDL_Texture* take_texture(int width, int height);
+        void draw_chunk(
+            const tile_map& map,
+            unsigned chunk_x, unsigned chunk_y,
+            const SDL_FRect& chunk_rect,
+            const SDL_Rect& tile_range,
+            unsigned layer_count
+        );
+
+    public:
+        explicit tile_chunk_cache(unsigned max_chunks = default_max_chunks);
+
+        /// <returns>
+        /// False if the renderer can't render to textures, can't create textures large enough for a few tiles, or a
+        /// chunk texture couldn't be created
+        /// </returns>
+        bool is_enabled() const { return enabled; }
+
+        /// <summary>
+        /// Call once per frame before any get_chunk calls, chunks used in the current frame are never reused for
+        /// another chunk in the same frame. This also picks the chunk size that fits the renderer's texture limits.
+        /// </summary>
+        /// <returns>False if the cache is disabled</returns>
+        bool begin_frame(SDL_Renderer* renderer, const tile_map& map);
+
+        /// <summary>
+        /// Gets the texture of layers 0 up to layer_count of a chunk, drawing it first if it's new or out of date. Must
+        /// be called before anything else is drawn for the frame, as it changes the render target while drawing.
+        /// </summary>
+        /// <returns>The chunk texture, or nullptr if the cache is (or has just become) disabled</returns>
+        SDL_Texture* get_chunk(
+            SDL_Renderer* renderer,
+            const tile_map& map,
+            unsigned chunk_x, unsigned chunk_y,
+            unsigned layer_count
+        );
+
+        /// <summary>
+        /// Gets where a chunk texture is drawn, relative to the position of the first (top left) tile of the chunk.
+        /// Chunks on the edges of the map are larger, to hold what the tiles on the edge draw outside of the map.
+        /// </summary>
+        SDL_FRect get_chunk_rect(const tile_map& map, unsigned chunk_x, unsigned chunk_y) const;
+
+        /// <returns>Tiles per chunk row and column, as picked by begin_frame()</returns>
+        unsigned get_chunk_tiles() const { return chunk_tiles; }
+        unsigned get_chunks_wide(const tile_map& map) const;
+        unsigned get_chunks_high(const tile_map& map) const;
+
+        /// <summary>
+        /// Destroy every cached texture, the renderer they were created with must still exist
+        /// </summary>
+        void clear();
+
+        size_t get_cached_chunk_count() const { return chunks.size(); }
+
+        /// <returns>How many chunk textures were redrawn since begin_frame()</returns>
+        unsigned get_redrawn_chunk_count() const { return redrawn_chunk_count; }
+    };
+
+}
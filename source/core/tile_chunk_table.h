@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace isometric {
+
+    /// <summary>
+    /// Per tile values for a whole map stored in fixed size square chunks. A chunk is only allocated once a value
+    /// that differs from the default is written to it, so unvisited or untouched areas of a map cost one pointer per
+    /// chunk. Every access is O(1): a shift and mask finds the chunk and the tile within it.
+    /// 
+    /// Chunks can also come from a memory mapped file (see attach_mapped). Those are resolved from the file's chunk
+    /// offset table the first time they're accessed, so the OS only pages in the chunks that are actually used.
+    /// </summary>
+    template<class T>
+    class tile_chunk_table
+    {
+    public:
+        static constexpr unsigned chunk_shift = 5;
+        static constexpr unsigned chunk_size = 1 << chunk_shift;    // Tiles per chunk row and column
+        static constexpr unsigned chunk_mask = chunk_size - 1;
+        static constexpr unsigned chunk_tiles = chunk_size * chunk_size;
+        static constexpr size_t chunk_bytes = chunk_tiles * sizeof(T);
+
+    private:
+        unsigned chunks_wide = 0;
+        unsigned chunks_high = 0;
+        T default_value = T();
+
+        std::vector<T*> chunks;                     // nullptr until the chunk has been allocated
+        std::vector<std::unique_ptr<T[]>> blocks;   // Owns the memory every allocated chunk points into
+        size_t allocated_chunks = 0;
+        size_t mapped_chunks = 0;
+
+        uint8_t* mapped_base = nullptr;                 // Start of a memory mapped file, if chunks are mapped
+        size_t mapped_size = 0;
+        size_t mapped_data_start = 0;                   // Chunks can't start before this, the file's metadata is there
+        const uint64_t* mapped_chunk_offsets = nullptr; // Byte offset of each chunk in the mapped file, 0 if absent
+
+        // A chunk must be aligned to its size (as tile_map::save places them) and lie between the end of the file's
+        // metadata and the end of the file, or a corrupt file could be read out of bounds or alias its own tables:
+        bool is_valid_mapped_offset(uint64_t offset) const
+        {
+            return offset >= mapped_data_start && offset % chunk_bytes == 0 &&
+                offset <= mapped_size && chunk_bytes <= mapped_size - offset;
+        }
+
+        T* find_mapped_chunk(size_t chunk_index) const
+        {
+            if (!mapped_chunk_offsets) return nullptr;
+
+            uint64_t offset = mapped_chunk_offsets[chunk_index];
+            if (offset == 0 || !is_valid_mapped_offset(offset)) return nullptr;
+
+            return reinterpret_cast<T*>(mapped_base + offset);
+        }
+
+    public:
+        /// <summary>
+        /// Setup the chunk table for a map of the given size in tiles
+        /// </summary>
+        /// <param name="allocate_all">True to allocate every chunk now as a single contiguous block</param>
+        void create(unsigned map_width, unsigned map_height, T default_value, bool allocate_all)
+        {
+            this->chunks_wide = (map_width + chunk_mask) >> chunk_shift;
+            this->chunks_high = (map_height + chunk_mask) >> chunk_shift;
+            this->default_value = default_value;
+
+            chunks.assign(get_chunk_count(), nullptr);
+            blocks.clear();
+            allocated_chunks = 0;
+            mapped_chunks = 0;
+
+            mapped_base = nullptr;
+            mapped_size = 0;
+            mapped_data_start = 0;
+            mapped_chunk_offsets = nullptr;
+
+            if (allocate_all && !chunks.empty())
+            {
+                auto block = std::unique_ptr<T[]>(new T[chunks.size() * chunk_tiles]);
+                std::fill(block.get(), block.get() + chunks.size() * chunk_tiles, default_value);
+
+                for (size_t chunk_index = 0; chunk_index < chunks.size(); chunk_index++)
+                {
+                    chunks[chunk_index] = block.get() + chunk_index * chunk_tiles;
+                }
+
+                allocated_chunks = chunks.size();
+                blocks.push_back(std::move(block));
+            }
+        }
+
+        /// <summary>
+        /// Use chunks stored in a memory mapped file. The mapping must be writable (copy-on-write) so that writes to a
+        /// mapped chunk never reach the file, and must outlive this table. Chunks that aren't aligned to chunk_bytes
+        /// or aren't within the mapping after data_start are treated as absent.
+        /// </summary>
+        /// <param name="data_start">Offset of the first byte after the file's header and tables</param>
+        /// <param name="chunk_offsets">get_chunk_count() byte offsets into the mapping, 0 for chunks not stored</param>
+        void attach_mapped(uint8_t* base, size_t size, size_t data_start, const uint64_t* chunk_offsets)
+        {
+            mapped_base = base;
+            mapped_size = size;
+            mapped_data_start = data_start;
+            mapped_chunk_offsets = chunk_offsets;
+
+            mapped_chunks = 0;
+            for (size_t chunk_index = 0; chunk_index < get_chunk_count(); chunk_index++)
+            {
+                if (!chunks[chunk_index] && find_mapped_chunk(chunk_index)) mapped_chunks++;
+            }
+        }
+
+        unsigned get_chunks_wide() const { return chunks_wide; }
+        unsigned get_chunks_high() const { return chunks_high; }
+        size_t get_chunk_count() const { return static_cast<size_t>(chunks_wide) * chunks_high; }
+        size_t get_allocated_chunk_count() const { return allocated_chunks; }
+        size_t get_mapped_chunk_count() const { return mapped_chunks; }
+        T get_default_value() const { return default_value; }
+
+        static size_t get_chunk_index(unsigned x, unsigned y, unsigned chunks_wide)
+        {
+            return static_cast<size_t>(x >> chunk_shift) + static_cast<size_t>(y >> chunk_shift) * chunks_wide;
+        }
+
+        static unsigned get_tile_index(unsigned x, unsigned y)
+        {
+            return (x & chunk_mask) + ((y & chunk_mask) << chunk_shift);
+        }
+
+        /// <returns>The chunk by its index, or nullptr if it has not been allocated or mapped</returns>
+        const T* get_chunk(size_t chunk_index) const
+        {
+            const T* chunk = chunks[chunk_index];
+            return chunk ? chunk : find_mapped_chunk(chunk_index);
+        }
+
+        /// <returns>The chunk containing the tile x, y or nullptr if it has not been allocated or mapped</returns>
+        const T* find_chunk(unsigned x, unsigned y) const
+        {
+            return get_chunk(get_chunk_index(x, y, chunks_wide));
+        }
+
+        /// <returns>The chunk containing the tile x, y, allocating it if needed</returns>
+        T* get_or_create_chunk(unsigned x, unsigned y)
+        {
+            size_t chunk_index = get_chunk_index(x, y, chunks_wide);
+            T*& chunk = chunks[chunk_index];
+
+            if (!chunk)
+            {
+                chunk = find_mapped_chunk(chunk_index);
+            }
+
+            if (!chunk)
+            {
+                auto block = std::unique_ptr<T[]>(new T[chunk_tiles]);
+                std::fill(block.get(), block.get() + chunk_tiles, default_value);
+
+                chunk = block.get();
+                blocks.push_back(std::move(block));
+                allocated_chunks++;
+            }
+
+            return chunk;
+        }
+
+        /// <summary>
+        /// Gets the value for a tile, x and y must be within the map
+        /// </summary>
+        T get(unsigned x, unsigned y) const
+        {
+            const T* chunk = find_chunk(x, y);
+            return chunk ? chunk[get_tile_index(x, y)] : default_value;
+        }
+
+        /// <summary>
+        /// Sets the value for a tile, x and y must be within the map. Writing the default value into a chunk that
+        /// hasn't been allocated does not allocate it.
+        /// </summary>
+        void set(unsigned x, unsigned y, T value)
+        {
+            if (value == default_value && !find_chunk(x, y)) return;
+
+            get_or_create_chunk(x, y)[get_tile_index(x, y)] = value;
+        }
+
+        /// <summary>
+        /// Gets a run of values starting at x, y that is contiguous in memory up to the right edge of its chunk
+        /// </summary>
+        /// <returns>A pointer to the value at x, y or nullptr if the chunk is unallocated (all default values)</returns>
+        const T* get_run(unsigned x, unsigned y) const
+        {
+            const T* chunk = find_chunk(x, y);
+            return chunk ? chunk + get_tile_index(x, y) : nullptr;
+        }
+    };
+
+}
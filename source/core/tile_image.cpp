@@ -30,4 +30,24 @@ const SDL_FRect* tile_image::get_dest_rect(float x, float y, unsigned tile_heigh
     };
 
     return &tmp_rect;
-}
\ No newline at end of file
+}
+
+tile_image_draw tile_image::get_draw(unsigned tile_height) const
+{
+    tile_image_draw draw;
+
+    draw.texture = texture;
+    draw.source_rect = *get_source_rect();
+
+    if (texture) SDL_QueryTexture(texture, nullptr, nullptr, &draw.texture_size.x, &draw.texture_size.y);
+
+    // Images taller than a tile are moved up so that their bottom lines up with the bottom of the tile:
+    draw.dest_rect = {
+        0.0f,
+        static_cast<float>(tile_height) - static_cast<float>(source_h),
+        static_cast<float>(source_w),
+        static_cast<float>(source_h)
+    };
+
+    return draw;
+}
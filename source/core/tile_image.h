@@ -5,6 +5,19 @@
 
 namespace isometric {
 
+    /// <summary>
+    /// Everything needed to draw a tile image on a tile, worked out once when the image is added to a map so that
+    /// rendering a tile is only an addition and a copy
+    /// </summary>
+    struct tile_image_draw
+    {
+        SDL_Texture* texture = nullptr;     // nullptr if there is no image
+        SDL_Rect source_rect = { 0 };       // Where the image is in the texture
+        SDL_FRect dest_rect = { 0 };        // Offset from the tile's position (bottom aligning the image) and size
+        SDL_Point texture_size = { 0 };     // Used to turn source_rect into texture coordinates
+        bool within_tile = false;           // True if dest_rect doesn't reach outside of the tile's own area
+    };
+
     class tile_image
     {
     private:
@@ -84,6 +97,11 @@ namespace isometric {
 
         const SDL_FRect* get_dest_rect(float x, float y, unsigned tile_height = 0) const;
 
+        /// <summary>
+        /// Create the draw record for this image when it is drawn on tiles of the given height
+        /// </summary>
+        tile_image_draw get_draw(unsigned tile_height) const;
+
         bool is_empty() const
         {
             return texture == NULL;
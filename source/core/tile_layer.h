@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "tile.h"
+#include "tile_chunk_table.h"
+
+namespace isometric {
+
+    /// <summary>
+    /// Everything a tile map knows about one of its layers. Layers are stored densely and indexed by their layer id,
+    /// so anything that runs per tile looks a layer up by id and never by name.
+    /// </summary>
+    struct tile_layer
+    {
+        std::string name;                               // Only used to find the layer id at setup time
+        tile_chunk_table<tile_image_index> images;      // One image index per tile
+
+        std::vector<unsigned> default_images;           // Used for tiles without an image
+        std::vector<unsigned> default_weights;          // Running total of the default image weights
+
+        bool visible = true;
+        uint8_t opacity = 255;      // Applied to every image drawn in this layer
+        bool is_static = false;     // Static layers are expected to change rarely, if ever, once the map is setup
+
+        bool has_default_images() const
+        {
+            return !default_images.empty();
+        }
+    };
+
+}
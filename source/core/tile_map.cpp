@@ -1,11 +1,37 @@
 #include "tile_map.h"
-#include "../source/tools/random.h"
+#include "tile_map_file.h"
 #include <limits>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
 
 using namespace isometric;
 using namespace isometric::tools;
 
-std::shared_ptr<tile_map> tile_map::create(unsigned map_width, unsigned map_height, unsigned tile_width, unsigned tile_height)
+// Mixes a tile's position, layer and the map's seed into a well distributed 32-bit value (the multipliers are
+// large odd constants and the last steps are MurmurHash3's finalizer):
+static uint32_t hash_tile(unsigned x, unsigned y, unsigned layer_id, uint32_t seed)
+{
+    uint32_t hash = seed;
+    hash += x * 0x8DA6B343u;
+    hash += y * 0xD8163841u;
+    hash += layer_id * 0xCB1AB31Fu;
+
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+std::shared_ptr<tile_map> tile_map::create(
+    unsigned map_width, unsigned map_height,
+    unsigned tile_width, unsigned tile_height,
+    tile_map_storage storage
+)
 {
     std::shared_ptr<tile_map> new_tile_map = std::shared_ptr<tile_map>(new tile_map);
 
@@ -13,33 +39,371 @@ std::shared_ptr<tile_map> tile_map::create(unsigned map_width, unsigned map_heig
     new_tile_map->map_height = map_height;
     new_tile_map->tile_width = tile_width;
     new_tile_map->tile_height = tile_height;
-    new_tile_map->tiles.resize(static_cast<size_t>(map_width * map_height));
+    new_tile_map->storage = storage;
+    new_tile_map->tile_image_bounds = { 0.0f, 0.0f, static_cast<float>(tile_width), static_cast<float>(tile_height) };
+    new_tile_map->tile_flags.create(map_width, map_height, tile_flags_default, storage == tile_map_storage::dense);
+    new_tile_map->static_chunk_revisions.assign(new_tile_map->tile_flags.get_chunk_count(), 0);
 
-    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Created tile map [ %u x %u / %llu tiles ], [ %u x %u tile size]",
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Created %s tile map [ %u x %u / %llu tiles ], [ %u x %u tile size]",
+        storage == tile_map_storage::dense ? "dense" : "chunked",
         new_tile_map->map_width, new_tile_map->map_height,
-        new_tile_map->tiles.size(),
+        static_cast<unsigned long long>(map_width) * map_height,
         new_tile_map->tile_width, new_tile_map->tile_height
     );
 
     return new_tile_map;
 }
 
-unsigned tile_map::add_image(std::shared_ptr<tile_image> image)
+static bool is_valid_file_range(uint64_t offset, uint64_t size, uint64_t file_size, uint64_t alignment = 1)
 {
-    tile_images[image->get_image_id()] = image;
-    return image->get_image_id();
+    return offset % alignment == 0 && offset <= file_size && size <= file_size - offset;
 }
 
-std::shared_ptr<tile_image> tile_map::get_image(unsigned id) const
+static uint64_t align_offset(uint64_t offset, uint64_t alignment)
 {
-    if (tile_images.contains(id))
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+std::shared_ptr<tile_map> tile_map::load(const std::string& path)
+{
+    auto file = tools::mapped_file::open(path);
+    if (!file)
     {
-        return tile_images.at(id);
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Map file '%s' could not be opened", path.c_str());
+        return nullptr;
     }
-    else
+
+    uint8_t* data = file->get_data();
+    const uint64_t file_size = file->get_size();
+
+    if (file_size < sizeof(tile_map_file_header))
     {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Map file '%s' is too small to be a map file", path.c_str());
         return nullptr;
     }
+
+    const auto& header = *reinterpret_cast<const tile_map_file_header*>(data);
+
+    if (std::memcmp(header.magic, tile_map_file_magic, sizeof(header.magic)) != 0 ||
+        header.version != tile_map_file_version ||
+        header.chunk_size != chunk_size)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Map file '%s' is not a version %u map file with %u tile chunks",
+            path.c_str(), tile_map_file_version, chunk_size);
+        return nullptr;
+    }
+
+    auto new_tile_map = create(
+        header.map_width, header.map_height,
+        header.tile_width, header.tile_height,
+        tile_map_storage::chunked
+    );
+
+    const uint64_t chunk_table_size = new_tile_map->tile_flags.get_chunk_count() * sizeof(uint64_t);
+
+    if (!is_valid_file_range(header.layers_offset, header.layer_count * sizeof(tile_map_file_layer), file_size,
+        alignof(tile_map_file_layer)) ||
+        !is_valid_file_range(header.flags_chunk_table_offset, chunk_table_size, file_size, alignof(uint64_t)))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Map file '%s' has an invalid layer or chunk table", path.c_str());
+        return nullptr;
+    }
+
+    // Everything before the first chunk is metadata: the header, the layer table, the chunk tables and the default
+    // images. Check all of it before anything is used, noting where it ends so no chunk can overlap it:
+    const auto* file_layers = reinterpret_cast<const tile_map_file_layer*>(data + header.layers_offset);
+
+    uint64_t data_start = std::max<uint64_t>(sizeof(tile_map_file_header),
+        header.layers_offset + header.layer_count * sizeof(tile_map_file_layer));
+    data_start = std::max(data_start, header.flags_chunk_table_offset + chunk_table_size);
+
+    std::vector<std::string> layer_names;
+
+    for (uint32_t file_layer_index = 0; file_layer_index < header.layer_count; file_layer_index++)
+    {
+        const auto& file_layer = file_layers[file_layer_index];
+        const uint64_t default_images_size = file_layer.default_image_count * sizeof(tile_map_file_default_image);
+
+        if (!is_valid_file_range(file_layer.chunk_table_offset, chunk_table_size, file_size, alignof(uint64_t)) ||
+            !is_valid_file_range(file_layer.default_images_offset, default_images_size, file_size,
+                alignof(tile_map_file_default_image)))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Map file '%s' has an invalid layer %u", path.c_str(),
+                file_layer_index);
+            return nullptr;
+        }
+
+        std::string layer_name(file_layer.name, strnlen(file_layer.name, sizeof(file_layer.name)));
+        if (std::find(layer_names.begin(), layer_names.end(), layer_name) != layer_names.end())
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Map file '%s' has more than one layer named [%s]",
+                path.c_str(), layer_name.c_str());
+            return nullptr;
+        }
+
+        layer_names.push_back(std::move(layer_name));
+        data_start = std::max(data_start, file_layer.chunk_table_offset + chunk_table_size);
+        data_start = std::max(data_start, file_layer.default_images_offset + default_images_size);
+    }
+
+    new_tile_map->tile_flags.attach_mapped(data, file_size, data_start,
+        reinterpret_cast<const uint64_t*>(data + header.flags_chunk_table_offset)
+    );
+
+    for (uint32_t file_layer_index = 0; file_layer_index < header.layer_count; file_layer_index++)
+    {
+        const auto& file_layer = file_layers[file_layer_index];
+        unsigned layer_id = new_tile_map->add_layer(layer_names[file_layer_index]);
+
+        auto& layer = new_tile_map->layers[layer_id];
+
+        layer.images.attach_mapped(data, file_size, data_start,
+            reinterpret_cast<const uint64_t*>(data + file_layer.chunk_table_offset)
+        );
+
+        layer.visible = (file_layer.flags & tile_map_file_layer_visible) != 0;
+        layer.is_static = (file_layer.flags & tile_map_file_layer_static) != 0;
+        layer.opacity = file_layer.opacity;
+
+        const auto* default_images =
+            reinterpret_cast<const tile_map_file_default_image*>(data + file_layer.default_images_offset);
+
+        for (uint32_t i = 0; i < file_layer.default_image_count; i++)
+        {
+            if (!new_tile_map->add_layer_default_image(layer_id, default_images[i].image_id, default_images[i].weight))
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Map file '%s' has an invalid default image in layer %u",
+                    path.c_str(), file_layer_index);
+                return nullptr;
+            }
+        }
+    }
+
+    new_tile_map->seed = header.seed;
+    new_tile_map->mapped_map_file = std::move(file);
+    new_tile_map->mapped_map_path = path;
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Mapped tile map file '%s' [ %llu bytes, %u layers ]",
+        path.c_str(), static_cast<unsigned long long>(file_size), header.layer_count);
+
+    return new_tile_map;
+}
+
+bool tile_map::save(const std::string& path) const
+{
+    if (mapped_map_file && path == mapped_map_path)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Can't save a map over the file it is mapped from: '%s'",
+            path.c_str());
+        return false;
+    }
+
+    const size_t chunk_count = tile_flags.get_chunk_count();
+    const uint32_t layer_count = static_cast<uint32_t>(layers.size());
+
+    // Work out where everything goes before writing anything:
+    tile_map_file_header header = {};
+    std::memcpy(header.magic, tile_map_file_magic, sizeof(header.magic));
+    header.version = tile_map_file_version;
+    header.map_width = map_width;
+    header.map_height = map_height;
+    header.tile_width = tile_width;
+    header.tile_height = tile_height;
+    header.chunk_size = chunk_size;
+    header.layer_count = layer_count;
+    header.seed = seed;
+
+    uint64_t offset = sizeof(tile_map_file_header);
+    header.layers_offset = offset;
+    offset += layer_count * sizeof(tile_map_file_layer);
+
+    std::vector<tile_map_file_layer> file_layers(layer_count);
+    for (uint32_t layer_id = 0; layer_id < layer_count; layer_id++)
+    {
+        auto& file_layer = file_layers[layer_id];
+        const auto& layer = layers[layer_id];
+        const auto& layer_name = layer.name;
+
+        if (layer_name.size() >= sizeof(file_layer.name))
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Layer name [%s] will be truncated to %u characters",
+                layer_name.c_str(), tile_map_file_max_layer_name - 1);
+        }
+
+        // file_layers is zero initialized, so copying at most one less than the size keeps the name null terminated:
+        std::memcpy(file_layer.name, layer_name.c_str(), std::min(layer_name.size(), sizeof(file_layer.name) - 1));
+
+        file_layer.flags = static_cast<uint8_t>(
+            (layer.visible ? tile_map_file_layer_visible : 0) |
+            (layer.is_static ? tile_map_file_layer_static : 0)
+        );
+        file_layer.opacity = layer.opacity;
+
+        file_layer.default_images_offset = offset;
+        file_layer.default_image_count = static_cast<uint32_t>(layer.default_images.size());
+
+        offset += file_layer.default_image_count * sizeof(tile_map_file_default_image);
+    }
+
+    offset = align_offset(offset, sizeof(uint64_t));
+    header.flags_chunk_table_offset = offset;
+    offset += chunk_count * sizeof(uint64_t);
+
+    for (auto& file_layer : file_layers)
+    {
+        file_layer.chunk_table_offset = offset;
+        offset += chunk_count * sizeof(uint64_t);
+    }
+
+    // Chunks are aligned to their own size so they never straddle more pages than they need to:
+    auto place_chunks = [&](const auto& table, std::vector<uint64_t>& chunk_offsets)
+    {
+        constexpr size_t chunk_bytes = std::remove_reference_t<decltype(table)>::chunk_bytes;
+        chunk_offsets.assign(chunk_count, 0);
+
+        for (size_t chunk_index = 0; chunk_index < chunk_count; chunk_index++)
+        {
+            if (!table.get_chunk(chunk_index)) continue;
+
+            offset = align_offset(offset, chunk_bytes);
+            chunk_offsets[chunk_index] = offset;
+            offset += chunk_bytes;
+        }
+    };
+
+    std::vector<uint64_t> flags_chunk_offsets;
+    std::vector<std::vector<uint64_t>> layer_chunk_offsets(layer_count);
+
+    place_chunks(tile_flags, flags_chunk_offsets);
+    for (uint32_t layer_id = 0; layer_id < layer_count; layer_id++)
+    {
+        place_chunks(layers[layer_id].images, layer_chunk_offsets[layer_id]);
+    }
+
+    // Now write it all out in order, padding with zeroes to reach each offset:
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open map file '%s' for writing", path.c_str());
+        return false;
+    }
+
+    uint64_t written = 0;
+    auto write_at = [&](uint64_t write_offset, const void* source, size_t size)
+    {
+        static const char zeroes[64] = {};
+        while (written < write_offset)
+        {
+            size_t padding = static_cast<size_t>(std::min<uint64_t>(write_offset - written, sizeof(zeroes)));
+            file.write(zeroes, padding);
+            written += padding;
+        }
+
+        file.write(static_cast<const char*>(source), size);
+        written += size;
+    };
+
+    write_at(0, &header, sizeof(header));
+    write_at(header.layers_offset, file_layers.data(), file_layers.size() * sizeof(tile_map_file_layer));
+
+    for (uint32_t layer_id = 0; layer_id < layer_count; layer_id++)
+    {
+        if (file_layers[layer_id].default_image_count == 0) continue;
+
+        const auto& image_ids = layers[layer_id].default_images;
+        const auto weights = get_layer_default_image_weights(layers[layer_id].name);
+
+        std::vector<tile_map_file_default_image> default_images;
+        for (size_t i = 0; i < image_ids.size(); i++)
+        {
+            default_images.push_back(tile_map_file_default_image{ image_ids[i], weights[i] });
+        }
+
+        write_at(file_layers[layer_id].default_images_offset, default_images.data(),
+            default_images.size() * sizeof(tile_map_file_default_image));
+    }
+
+    write_at(header.flags_chunk_table_offset, flags_chunk_offsets.data(), chunk_count * sizeof(uint64_t));
+    for (uint32_t layer_id = 0; layer_id < layer_count; layer_id++)
+    {
+        write_at(file_layers[layer_id].chunk_table_offset, layer_chunk_offsets[layer_id].data(),
+            chunk_count * sizeof(uint64_t));
+    }
+
+    for (size_t chunk_index = 0; chunk_index < chunk_count; chunk_index++)
+    {
+        if (flags_chunk_offsets[chunk_index] == 0) continue;
+        write_at(flags_chunk_offsets[chunk_index], tile_flags.get_chunk(chunk_index), tile_flags.chunk_bytes);
+    }
+
+    for (uint32_t layer_id = 0; layer_id < layer_count; layer_id++)
+    {
+        const auto& table = layers[layer_id].images;
+
+        for (size_t chunk_index = 0; chunk_index < chunk_count; chunk_index++)
+        {
+            if (layer_chunk_offsets[layer_id][chunk_index] == 0) continue;
+            write_at(layer_chunk_offsets[layer_id][chunk_index], table.get_chunk(chunk_index), table.chunk_bytes);
+        }
+    }
+
+    if (!file)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write map file '%s'", path.c_str());
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Saved tile map file '%s' [ %llu bytes ]",
+        path.c_str(), static_cast<unsigned long long>(written));
+
+    return true;
+}
+
+unsigned tile_map::add_image(std::shared_ptr<tile_image> image)
+{
+    // Image ids are stored in the layer arrays as a tile_image_index, so they have to fit while leaving room for the
+    // empty tile sentinel:
+    if (image->get_image_id() >= empty_tile_image)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Tile image id %u is too large, image ids must be less than %u",
+            image->get_image_id(), static_cast<unsigned>(empty_tile_image));
+        return std::numeric_limits<unsigned>::max();
+    }
+
+    const unsigned image_id = image->get_image_id();
+    if (image_id >= tile_images.size())
+    {
+        tile_images.resize(image_id + 1);
+        tile_image_draws.resize(image_id + 1);
+    }
+
+    tile_images[image_id] = image;
+    tile_image_draws[image_id] = image->get_draw(tile_height);
+
+    const SDL_FRect& dest_rect = tile_image_draws[image_id].dest_rect;
+    tile_image_draws[image_id].within_tile = dest_rect.x >= 0.0f && dest_rect.y >= 0.0f &&
+        dest_rect.x + dest_rect.w <= static_cast<float>(tile_width) &&
+        dest_rect.y + dest_rect.h <= static_cast<float>(tile_height);
+
+    float left = std::min(tile_image_bounds.x, dest_rect.x);
+    float top = std::min(tile_image_bounds.y, dest_rect.y);
+    float right = std::max(tile_image_bounds.x + tile_image_bounds.w, dest_rect.x + dest_rect.w);
+    float bottom = std::max(tile_image_bounds.y + tile_image_bounds.h, dest_rect.y + dest_rect.h);
+    tile_image_bounds = { left, top, right - left, bottom - top };
+
+    static_revision++;
+
+    return image_id;
+}
+
+const SDL_FRect& tile_map::get_image_bounds() const
+{
+    return tile_image_bounds;
+}
+
+std::shared_ptr<tile_image> tile_map::get_image(unsigned id) const
+{
+    return id < tile_images.size() ? tile_images[id] : nullptr;
 }
 
 void tile_map::set_selection_image(unsigned id)
@@ -49,50 +413,45 @@ void tile_map::set_selection_image(unsigned id)
 
 bool tile_map::has_selection_image() const
 {
-    return tile_images.contains(selection_tile_image);
+    return get_image_draw(selection_tile_image) != nullptr;
 }
 
 std::shared_ptr<tile_image> tile_map::get_selection_image() const
 {
-    if (has_selection_image())
-    {
-        return tile_images.at(selection_tile_image);
-    }
-    else
-    {
-        return nullptr;
-    }
+    return get_image(selection_tile_image);
+}
+
+const tile_image_draw* tile_map::get_selection_image_draw() const
+{
+    return get_image_draw(selection_tile_image);
 }
 
 unsigned tile_map::add_layer(const std::string& layer_name)
 {
-    if (std::find(layers.begin(), layers.end(), layer_name) == layers.end() /* Not found */)
-    {
-        layers.push_back(layer_name);
-        return static_cast<unsigned>(layers.size() - 1);
-    }
-    else
-    {
-        return get_layer_id(layer_name);
-    }
+    unsigned layer_id = get_layer_id(layer_name);
+    if (layer_id != std::numeric_limits<unsigned>::max()) return layer_id;
+
+    auto& layer = layers.emplace_back();
+    layer.name = layer_name;
+    layer.images.create(map_width, map_height, empty_tile_image, storage == tile_map_storage::dense);
+    static_revision++;
+
+    return static_cast<unsigned>(layers.size() - 1);
 }
 
-const std::vector<std::string>& tile_map::get_layers() const
+unsigned tile_map::get_layer_count() const
 {
-    return layers;
+    return static_cast<unsigned>(layers.size());
 }
 
 unsigned tile_map::get_layer_id(const std::string& layer_name) const
 {
-    auto iter = std::find(layers.begin(), layers.end(), layer_name);
-    if (iter != layers.end())
-    {
-        return static_cast<unsigned>(std::distance(layers.begin(), iter));
-    }
-    else
+    for (size_t layer_id = 0; layer_id < layers.size(); layer_id++)
     {
-        return std::numeric_limits<unsigned>::max();
+        if (layers[layer_id].name == layer_name) return static_cast<unsigned>(layer_id);
     }
+
+    return std::numeric_limits<unsigned>::max();
 }
 
 const std::string& tile_map::get_layer_name(unsigned layer_id) const
@@ -102,13 +461,64 @@ const std::string& tile_map::get_layer_name(unsigned layer_id) const
     if (layer_id >= layers.size()) return empty_string;
     else
     {
-        return layers[layer_id];
+        return layers[layer_id].name;
     }
 }
 
-const std::vector<tile>& tile_map::get_tiles() const
+const tile_layer& tile_map::get_layer(unsigned layer_id) const
+{
+    return layers[layer_id];
+}
+
+void tile_map::set_layer_visible(unsigned layer_id, bool visible)
+{
+    if (layer_id >= layers.size()) return;
+
+    layers[layer_id].visible = visible;
+    static_revision++;
+}
+
+void tile_map::set_layer_opacity(unsigned layer_id, uint8_t opacity)
+{
+    if (layer_id >= layers.size()) return;
+
+    layers[layer_id].opacity = opacity;
+    static_revision++;
+}
+
+void tile_map::set_layer_static(unsigned layer_id, bool is_static)
+{
+    if (layer_id >= layers.size()) return;
+
+    layers[layer_id].is_static = is_static;
+    static_revision++;
+}
+
+unsigned tile_map::get_chunks_wide() const
+{
+    return tile_flags.get_chunks_wide();
+}
+
+unsigned tile_map::get_chunks_high() const
+{
+    return tile_flags.get_chunks_high();
+}
+
+uint32_t tile_map::get_static_chunk_revision(unsigned chunk_x, unsigned chunk_y) const
 {
-    return tiles;
+    if (chunk_x >= get_chunks_wide() || chunk_y >= get_chunks_high()) return 0;
+
+    return static_chunk_revisions[static_cast<size_t>(chunk_y) * get_chunks_wide() + chunk_x];
+}
+
+uint32_t tile_map::get_static_revision() const
+{
+    return static_revision;
+}
+
+void tile_map::static_chunk_changed(unsigned x, unsigned y)
+{
+    static_chunk_revisions[tile_chunk_table<uint8_t>::get_chunk_index(x, y, get_chunks_wide())]++;
 }
 
 unsigned tile_map::get_tile_width() const
@@ -121,6 +531,23 @@ unsigned tile_map::get_tile_height() const
     return tile_height;
 }
 
+tile_map_storage tile_map::get_storage() const
+{
+    return storage;
+}
+
+size_t tile_map::get_allocated_chunk_count() const
+{
+    size_t allocated_chunks = tile_flags.get_allocated_chunk_count() + tile_flags.get_mapped_chunk_count();
+
+    for (const auto& layer : layers)
+    {
+        allocated_chunks += layer.images.get_allocated_chunk_count() + layer.images.get_mapped_chunk_count();
+    }
+
+    return allocated_chunks;
+}
+
 unsigned tile_map::get_map_width() const
 {
     return map_width;
@@ -131,74 +558,192 @@ unsigned tile_map::get_map_height() const
     return map_height;
 }
 
-tile* tile_map::get_tile(unsigned x, unsigned y)
+bool tile_map::is_inside(unsigned x, unsigned y) const
 {
-    unsigned tile_index = x + y * get_map_width();
+    return x < map_width && y < map_height;
+}
 
-    if (tile_index >= 0 && tile_index < tiles.size())
-    {
-        return &tiles[tile_index];
-    }
+tile tile_map::get_tile(unsigned x, unsigned y)
+{
+    if (!is_inside(x, y)) return tile();
 
-    return nullptr;
+    return tile(this, x, y);
 }
 
-tile* tile_map::set_tile(unsigned x, unsigned y, const tile& tile_source)
+tile tile_map::set_tile(unsigned x, unsigned y, bool passable, bool enabled)
 {
-    unsigned tile_index = x + y * get_map_width();
+    if (!is_inside(x, y)) return tile();
+
+    tile_flags.set(x, y, static_cast<uint8_t>(
+        (passable ? tile_flag_passable : tile_flag_none) |
+        (enabled ? tile_flag_enabled : tile_flag_none)
+    ));
 
-    if (tile_index >= 0 && tile_index < tiles.size())
+    for (auto& layer : layers)
     {
-        tiles[tile_index] = tile_source;
-        return &tiles[tile_index];
+        if (layer.is_static && layer.images.get(x, y) != empty_tile_image) static_chunk_changed(x, y);
+        layer.images.set(x, y, empty_tile_image);
     }
-    else
+
+    return tile(this, x, y);
+}
+
+uint8_t tile_map::get_tile_flags(unsigned x, unsigned y) const
+{
+    if (!is_inside(x, y)) return tile_flag_none;
+
+    return tile_flags.get(x, y);
+}
+
+void tile_map::set_tile_flags(unsigned x, unsigned y, uint8_t flags)
+{
+    if (!is_inside(x, y)) return;
+
+    tile_flags.set(x, y, flags);
+}
+
+bool tile_map::has_image(unsigned x, unsigned y, unsigned layer_id) const
+{
+    if (!is_inside(x, y) || layer_id >= layers.size()) return false;
+
+    const auto& layer = layers[layer_id];
+    return layer.images.get(x, y) != empty_tile_image || layer.has_default_images();
+}
+
+unsigned tile_map::get_image_id(unsigned x, unsigned y, unsigned layer_id) const
+{
+    if (!is_inside(x, y) || layer_id >= layers.size()) return 0;
+
+    tile_image_index image_index = layers[layer_id].images.get(x, y);
+    if (image_index != empty_tile_image) return image_index;
+
+    unsigned default_image_id = get_layer_default_image(x, y, layer_id);
+    return default_image_id != empty_tile_image ? default_image_id : 0;
+}
+
+void tile_map::set_image_id(unsigned x, unsigned y, unsigned layer_id, unsigned image_id)
+{
+    if (!is_inside(x, y) || layer_id >= layers.size()) return;
+
+    auto& layer = layers[layer_id];
+    tile_image_index image_index = image_id < empty_tile_image
+        ? static_cast<tile_image_index>(image_id)
+        : empty_tile_image;
+
+    if (layer.is_static && layer.images.get(x, y) != image_index) static_chunk_changed(x, y);
+    layer.images.set(x, y, image_index);
+}
+
+const tile_image_index* tile_map::get_layer_run(unsigned layer_id, unsigned x, unsigned y) const
+{
+    if (!is_inside(x, y) || layer_id >= layers.size()) return nullptr;
+
+    return layers[layer_id].images.get_run(x, y);
+}
+
+bool tile_map::add_layer_default_image(const std::string& layer_name, unsigned image_id, unsigned weight)
+{
+    unsigned layer_id = get_layer_id(layer_name);
+    if (layer_id == std::numeric_limits<unsigned>::max())
     {
-        return nullptr;
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Can't add a default image to layer [%s], it hasn't been added",
+            layer_name.c_str());
+        return false;
     }
+
+    return add_layer_default_image(layer_id, image_id, weight);
 }
 
-void tile_map::add_layer_default_image(const std::string& layer_name, unsigned image_id)
+bool tile_map::add_layer_default_image(unsigned layer_id, unsigned image_id, unsigned weight)
 {
-    layer_default_images[layer_name].push_back(image_id);
+    if (layer_id >= layers.size()) return false;
+
+    // Default images end up in the same tile_image_index slots as the images set on tiles:
+    if (image_id >= empty_tile_image)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Default tile image id %u is too large, image ids must be less "
+            "than %u", image_id, static_cast<unsigned>(empty_tile_image));
+        return false;
+    }
+
+    auto& layer = layers[layer_id];
+    const unsigned total = layer.default_weights.empty() ? 0 : layer.default_weights.back();
+
+    if (weight == 0 || weight > std::numeric_limits<unsigned>::max() - total)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Default tile image %u has an invalid weight %u, weights have to "
+            "be at least 1 and add up to at most %u", image_id, weight, std::numeric_limits<unsigned>::max());
+        return false;
+    }
+
+    layer.default_weights.push_back(total + weight);
+    layer.default_images.push_back(image_id);
+    static_revision++;
+    return true;
 }
 
 const std::vector<unsigned>& tile_map::get_layer_default_images(const std::string& layer_name) const
 {
-    return layer_default_images.at(layer_name);
+    static const std::vector<unsigned> no_images;
+
+    unsigned layer_id = get_layer_id(layer_name);
+    return layer_id < layers.size() ? layers[layer_id].default_images : no_images;
 }
 
-unsigned tile_map::get_random_layer_default_image(const std::string& layer_name) const
+std::vector<unsigned> tile_map::get_layer_default_image_weights(const std::string& layer_name) const
 {
-    if (layer_has_default_images(layer_name))
-    {
-        unsigned random_index = random::range(0U, (unsigned)layer_default_images.at(layer_name).size() - 1U);
-        return layer_default_images.at(layer_name)[random_index];
-    }
-    else
+    std::vector<unsigned> weights;
+
+    unsigned layer_id = get_layer_id(layer_name);
+    if (layer_id >= layers.size()) return weights;
+
+    unsigned previous_total = 0;
+    for (unsigned total : layers[layer_id].default_weights)
     {
-        return 0;
+        weights.push_back(total - previous_total);
+        previous_total = total;
     }
+
+    return weights;
+}
+
+unsigned tile_map::get_layer_default_image(unsigned x, unsigned y, const std::string& layer_name) const
+{
+    return get_layer_default_image(x, y, get_layer_id(layer_name));
 }
 
-unsigned tile_map::get_random_layer_default_image(unsigned layer_id) const
+unsigned tile_map::get_layer_default_image(unsigned x, unsigned y, unsigned layer_id) const
 {
-    return get_random_layer_default_image(get_layer_name(layer_id));
+    if (!layer_has_default_images(layer_id)) return empty_tile_image;
+
+    const auto& layer = layers[layer_id];
+    const auto& weights = layer.default_weights;
+
+    // Scale the hash into the total weight without a division, then find the image whose weight covers it:
+    uint64_t hash = hash_tile(x, y, layer_id, seed);
+    uint32_t target = static_cast<uint32_t>((hash * weights.back()) >> 32);
+    size_t image_index = std::upper_bound(weights.begin(), weights.end(), target) - weights.begin();
+
+    return layer.default_images[image_index];
 }
 
 bool tile_map::layer_has_default_images(const std::string& layer_name) const
 {
-    return
-        layer_default_images.contains(layer_name) &&
-        layer_default_images.at(layer_name).size() > 0;
+    return layer_has_default_images(get_layer_id(layer_name));
 }
 
 bool tile_map::layer_has_default_images(unsigned layer_id) const
 {
-    if (layer_id >= layers.size()) return false;
-    else
-    {
-        auto& layer_name = layers[layer_id];
-        return layer_has_default_images(layer_name);
-    }
-}
\ No newline at end of file
+    return layer_id < layers.size() && layers[layer_id].has_default_images();
+}
+
+uint32_t tile_map::get_seed() const
+{
+    return seed;
+}
+
+void tile_map::set_seed(uint32_t seed)
+{
+    this->seed = seed;
+    static_revision++;
+}
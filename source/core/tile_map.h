@@ -1,13 +1,21 @@
 #pragma once
-#include <unordered_map>
 #include <string>
 #include <vector>
 #include <memory>
+#include <limits>
 #include "tile_image.h"
 #include "tile.h"
+#include "tile_chunk_table.h"
+#include "tile_layer.h"
+#include "../tools/mapped_file.h"
 
 namespace isometric {
 
+    enum class tile_map_storage {
+        dense,      // Every chunk is allocated when the map is created
+        chunked     // Chunks are allocated the first time a tile within them is written
+    };
+
     class tile_map
     {
     private:
@@ -15,17 +23,53 @@ namespace isometric {
         unsigned map_height = 0;    // by tiles
         unsigned tile_width = 0;    // by pixels
         unsigned tile_height = 0;   // by pixels
+        tile_map_storage storage = tile_map_storage::dense;
 
-        std::unordered_map<unsigned, std::shared_ptr<tile_image>> tile_images;
+        std::vector<std::shared_ptr<tile_image>> tile_images;       // Indexed by image id, nullptr if there's no image
+        std::vector<tile_image_draw> tile_image_draws;              // Indexed by image id
+        SDL_FRect tile_image_bounds = { 0 };                        // Union of every image's dest_rect
         unsigned selection_tile_image = std::numeric_limits<unsigned>::max();
-        std::vector<tile> tiles;
-        std::unordered_map<std::string, std::vector<unsigned>> layer_default_images;
-        std::vector<std::string> layers;
+        tile_chunk_table<uint8_t> tile_flags;                       // One set of tile_flags per tile
+        std::vector<tile_layer> layers;                             // Indexed by layer id
+        uint32_t seed = 0;
+
+        std::vector<uint32_t> static_chunk_revisions;   // Per chunk, changes when a tile of a static layer changes
+        uint32_t static_revision = 0;                   // Changes when something that affects every tile changes
+
+        void static_chunk_changed(unsigned x, unsigned y);
+
+        std::unique_ptr<tools::mapped_file> mapped_map_file = nullptr; // Backs chunks loaded from a map file
+        std::string mapped_map_path;
 
         tile_map() {}
 
     public:
-        static std::shared_ptr<tile_map> create(unsigned map_width, unsigned map_height, unsigned tile_width, unsigned tile_height);
+        using layer_chunk_table = tile_chunk_table<tile_image_index>;
+        static constexpr unsigned chunk_size = layer_chunk_table::chunk_size;
+
+        static std::shared_ptr<tile_map> create(
+            unsigned map_width, unsigned map_height,
+            unsigned tile_width, unsigned tile_height,
+            tile_map_storage storage = tile_map_storage::dense
+        );
+
+        /// <summary>
+        /// Load a map from a binary map file (see tile_map_file.h). The file is memory mapped and its chunks are used
+        /// in place, so loading takes the same time regardless of the size of the map and the OS only pages in the
+        /// chunks that are accessed. Tiles that are changed afterwards are copied-on-write and never reach the file.
+        /// Images are not stored in map files and have to be added after loading.
+        /// </summary>
+        /// <param name="path">Path to the map file</param>
+        /// <returns>The loaded map using chunked storage, or nullptr if the file is missing or invalid</returns>
+        static std::shared_ptr<tile_map> load(const std::string& path);
+
+        /// <summary>
+        /// Save the layers, default layer images and tiles of this map to a binary map file. Only chunks that are
+        /// allocated are written. A map can't be saved over the file it was loaded from.
+        /// </summary>
+        /// <param name="path">Path to the map file, it is replaced if it already exists</param>
+        /// <returns>True if the map was saved</returns>
+        bool save(const std::string& path) const;
 
         /// <Returns>
         /// Returns the width of the map (total tiles per row)
@@ -47,45 +91,103 @@ namespace isometric {
         /// </summary>
         unsigned get_tile_height() const;
 
+        tile_map_storage get_storage() const;
+
+        /// <summary>
+        /// Returns the number of chunks that currently have memory allocated for them or are mapped from the map
+        /// file, across all layers
+        /// </summary>
+        size_t get_allocated_chunk_count() const;
+
+        unsigned get_chunks_wide() const;
+        unsigned get_chunks_high() const;
+
+        /// <summary>
+        /// Gets a number that changes whenever a tile of a static layer within the chunk is changed by set_tile or
+        /// set_image_id. Anything built from the static layers of a chunk (such as a pre-rendered texture of it) is up
+        /// to date for as long as this and get_static_revision() return the same values they did when it was built.
+        /// </summary>
+        uint32_t get_static_chunk_revision(unsigned chunk_x, unsigned chunk_y) const;
+
+        /// <summary>
+        /// Gets a number that changes whenever something that can affect the appearance of any tile changes, such as
+        /// adding images, changing a layer's properties or default images, or changing the seed
+        /// </summary>
+        uint32_t get_static_revision() const;
+
         /// <summary>
         /// Add an image that this map can use for tiles
         /// </summary>
         /// <param name="image">A valid tile image within a shared_ptr</param>
+        /// <returns>The image id, or the max unsigned value if the id cannot be stored in a layer</returns>
         unsigned add_image(std::shared_ptr<tile_image> image);
 
         /// <summary>
         /// Get an image that this map uses for tiles
         /// </summary>
         /// <param name="id">The id of the image to return</param>
-        /// <returns>A valid tile image within a shared_ptr</returns>
+        /// <returns>A valid tile image within a shared_ptr, or nullptr if there is no image with this id</returns>
         std::shared_ptr<tile_image> get_image(unsigned id) const;
 
+        /// <summary>
+        /// Get the precomputed draw record of an image, for rendering. Unlike get_image this doesn't touch a
+        /// reference count, the record stays valid until another image is added to the map.
+        /// </summary>
+        /// <param name="id">The id of the image to draw</param>
+        /// <returns>The draw record, or nullptr if there is no image with this id</returns>
+        const tile_image_draw* get_image_draw(unsigned id) const
+        {
+            if (id >= tile_image_draws.size() || !tile_image_draws[id].texture) return nullptr;
+            return &tile_image_draws[id];
+        }
+
+        /// <summary>
+        /// Gets the area covered by every image of this map when drawn on a tile, relative to the tile's position.
+        /// This is at least the size of a tile and grows to include images that are taller or wider than a tile, so
+        /// it is how far outside of a tile's own area something drawn on that tile can reach.
+        /// </summary>
+        const SDL_FRect& get_image_bounds() const;
+
         void set_selection_image(unsigned id);
         bool has_selection_image() const;
         std::shared_ptr<tile_image> get_selection_image() const;
+        const tile_image_draw* get_selection_image_draw() const;
 
         /// <summary>
-        /// Set the image id used as the default for tiles that do not have an image in this layer
+        /// Add an image id used as a default for tiles that do not have an image in this layer
         /// </summary>
-        /// <param name="layer_name">The layer this default is set in</param>
+        /// <param name="layer_name">The layer this default is set in, it must have already been added</param>
         /// <param name="image_id">The id of the image to use as the default tile image</param>
-        void add_layer_default_image(const std::string& layer_name, unsigned image_id);
+        /// <param name="weight">How often this image is used relative to the layer's other default images</param>
+        /// <returns>
+        /// False if the layer doesn't exist, the image id is too large or the weight is 0 or overflows the layer's
+        /// total weight
+        /// </returns>
+        bool add_layer_default_image(const std::string& layer_name, unsigned image_id, unsigned weight = 1);
+        bool add_layer_default_image(unsigned layer_id, unsigned image_id, unsigned weight = 1);
 
         /// <summary>
         /// Gets all of the default tile images used for a layer
         /// </summary>
         /// <param name="layer_name">The layer associated with these default tile images</param>
-        /// <returns>A vector of tile image ids</returns>
+        /// <returns>A vector of tile image ids, empty if the layer doesn't exist</returns>
         const std::vector<unsigned>& get_layer_default_images(const std::string& layer_name) const;
 
         /// <summary>
-        /// Get a random default tile image set for a layer
+        /// Gets the weight of each of the default tile images used for a layer
         /// </summary>
-        /// <param name="layer_name">The layer associated with this random default tile image</param>
-        /// <remarks>If this layer does not have a default
-        /// <returns>The id of the image to use as the default tile image</returns>
-        unsigned get_random_layer_default_image(const std::string& layer_name) const;
-        unsigned get_random_layer_default_image(unsigned layer_id) const;
+        /// <param name="layer_name">The layer associated with these default tile images</param>
+        /// <returns>A vector of weights in the same order as get_layer_default_images</returns>
+        std::vector<unsigned> get_layer_default_image_weights(const std::string& layer_name) const;
+
+        /// <summary>
+        /// Get the default image for a tile in a layer. This is a pure function of the tile position, layer and the
+        /// map's seed (a hash picks from the layer's weighted default images), so it is never stored and the same map
+        /// and seed always produce the same world.
+        /// </summary>
+        /// <returns>The id of the image to use as the default tile image, or empty_tile_image if there are none</returns>
+        unsigned get_layer_default_image(unsigned x, unsigned y, const std::string& layer_name) const;
+        unsigned get_layer_default_image(unsigned x, unsigned y, unsigned layer_id) const;
 
         /// <summary>
         /// Determine if the layer has any default tile images
@@ -95,14 +197,63 @@ namespace isometric {
         bool layer_has_default_images(const std::string& layer_name) const;
         bool layer_has_default_images(unsigned layer_id) const;
 
+        uint32_t get_seed() const;
+        void set_seed(uint32_t seed);
+
+        /// <summary>
+        /// Add a layer, layers are drawn in the order they are added. Names are only for looking up the layer id while
+        /// setting up a map, everything else should hold on to the layer id.
+        /// </summary>
+        /// <returns>The id of the new layer, or of the existing layer with this name</returns>
         unsigned add_layer(const std::string& layer_name);
-        const std::vector<std::string>& get_layers() const;
+        unsigned get_layer_count() const;
         unsigned get_layer_id(const std::string& layer_name) const;
         const std::string& get_layer_name(unsigned layer_id) const;
 
-        tile* set_tile(unsigned x, unsigned y, const tile& tile_source);
-        tile* get_tile(unsigned x, unsigned y);
-        const std::vector<tile>& get_tiles() const;
+        /// <summary>
+        /// Get a layer by its id, layer_id must be less than get_layer_count()
+        /// </summary>
+        const tile_layer& get_layer(unsigned layer_id) const;
+
+        void set_layer_visible(unsigned layer_id, bool visible = true);
+        void set_layer_opacity(unsigned layer_id, uint8_t opacity);
+
+        /// <summary>
+        /// Mark a layer as static (rarely or never changes after setup) or dynamic (changes during play), this lets
+        /// the renderer decide how much work it can avoid redoing for the layer each frame
+        /// </summary>
+        void set_layer_static(unsigned layer_id, bool is_static = true);
+
+        /// <summary>
+        /// Reset a tile, clearing its image in every layer
+        /// </summary>
+        /// <returns>A view of the tile, which is invalid if x, y is outside of the map</returns>
+        tile set_tile(unsigned x, unsigned y, bool passable = true, bool enabled = true);
+
+        /// <returns>A view of the tile, which is invalid if x, y is outside of the map</returns>
+        tile get_tile(unsigned x, unsigned y);
+
+        bool is_inside(unsigned x, unsigned y) const;
+
+        uint8_t get_tile_flags(unsigned x, unsigned y) const;
+        void set_tile_flags(unsigned x, unsigned y, uint8_t flags);
+
+        /// <returns>True if the tile has an image set in this layer or the layer has default images</returns>
+        bool has_image(unsigned x, unsigned y, unsigned layer_id) const;
+
+        /// <returns>The image set for the tile in this layer, otherwise the layer's default image for the tile</returns>
+        unsigned get_image_id(unsigned x, unsigned y, unsigned layer_id) const;
+        void set_image_id(unsigned x, unsigned y, unsigned layer_id, unsigned image_id);
+
+        /// <summary>
+        /// Gets a run of image indices for a layer so that it can be scanned linearly. The run starts at x, y and is
+        /// contiguous up to the right edge of the chunk containing it (the next multiple of chunk_size). Tiles without
+        /// an image in this layer are set to empty_tile_image.
+        /// </summary>
+        /// <returns>
+        /// A pointer to the image index of x, y, or nullptr if the chunk has nothing stored in it for this layer
+        /// </returns>
+        const tile_image_index* get_layer_run(unsigned layer_id, unsigned x, unsigned y) const;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+
+namespace isometric {
+
+    // The binary map file is laid out so that it can be memory mapped and used by a tile_map as is, without parsing.
+    // All values are little-endian and every offset is in bytes from the start of the file:
+    //
+    //  tile_map_file_header
+    //  tile_map_file_layer[layer_count]
+    //  tile_map_file_default_image[default_image_count], for each layer
+    //  uint64_t flags chunk offsets[chunk_count]
+    //  uint64_t image chunk offsets[chunk_count], for each layer
+    //  Chunk data, each chunk aligned to its own size
+    //
+    // A chunk offset of 0 means the chunk isn't stored and all of its tiles have the default value.
+
+    constexpr char tile_map_file_magic[4] = { 'I', 'S', 'O', 'M' };
+    constexpr uint32_t tile_map_file_version = 3;
+    constexpr unsigned tile_map_file_max_layer_name = 64;
+
+    struct tile_map_file_header
+    {
+        char magic[4];
+        uint32_t version;
+
+        uint32_t map_width;
+        uint32_t map_height;
+        uint32_t tile_width;
+        uint32_t tile_height;
+
+        uint32_t chunk_size;
+        uint32_t layer_count;
+
+        uint64_t layers_offset;
+        uint64_t flags_chunk_table_offset;
+
+        uint32_t seed;      // Seed for the default layer images
+        uint32_t reserved;
+    };
+
+    enum tile_map_file_layer_flags : uint8_t {
+        tile_map_file_layer_visible = 1 << 0,
+        tile_map_file_layer_static = 1 << 1
+    };
+
+    struct tile_map_file_layer
+    {
+        char name[tile_map_file_max_layer_name]; // Null terminated
+        uint64_t chunk_table_offset;
+        uint64_t default_images_offset;
+        uint32_t default_image_count;
+        uint8_t flags;      // tile_map_file_layer_flags
+        uint8_t opacity;
+        uint16_t reserved;
+    };
+
+    struct tile_map_file_default_image
+    {
+        uint32_t image_id;
+        uint32_t weight;
+    };
+
+    static_assert(sizeof(tile_map_file_header) == 56, "tile_map_file_header must not contain padding");
+    static_assert(sizeof(tile_map_file_layer) == 88, "tile_map_file_layer must not contain padding");
+
+}
@@ -1,5 +1,6 @@
 #include "transform.h"
 #include <cmath>
+#include <algorithm>
 
 using namespace isometric;
 
@@ -45,76 +46,88 @@ bool transform::has_sanity() const
     return sanity;
 }
 
-SDL_FPoint transform::world_tile_to_world_pixels(const SDL_Point& tile_point) const
+view_transform transform::get_view() const
 {
-    if (!has_sanity()) return SDL_FPoint();
+    view_transform view;
+    if (!has_sanity()) return view;
+
+    view.tile_width = static_cast<float>(map->get_tile_width());
+    view.tile_height = static_cast<float>(map->get_tile_height());
+    view.half_tile_height = view.tile_height / 2.0f;
+    view.even_row_stagger = -view.tile_width / 2.0f;
+
+    // World pixels are moved so the camera's position is at the top left of the viewport (see
+    // world_tile_to_world_pixels for how tiles are placed in the world, the whole world is shifted up half a tile):
+    view.world_x = main_camera->get_viewport_x() - main_camera->get_current_x() * view.tile_width;
+    view.world_y = main_camera->get_viewport_y() - main_camera->get_current_y() * view.half_tile_height;
+    view.tile_x = view.world_x;
+    view.tile_y = view.world_y - view.half_tile_height;
+
+    view.valid = view.tile_width > 0.0f && view.tile_height > 0.0f;
+    return view;
+}
 
+// The world pixel position of a tile, the transform's sanity has to have been checked:
+static SDL_FPoint tile_to_world_pixels(const tile_map& map, const SDL_Point& tile_point)
+{
     float world_x =
         // The x coordinate is the tile column position multiplied by the pixel width of a tile:
-        tile_point.x * map->get_tile_width() +
+        tile_point.x * map.get_tile_width() +
         (
             static_cast<int>(tile_point.y) % 2 == 0             // Is this an even tile?
-            ? -static_cast<int>(map->get_tile_width()) / 2.0f   // True:  Offset the tile half a tile to the left
+            ? -static_cast<int>(map.get_tile_width()) / 2.0f    // True:  Offset the tile half a tile to the left
             : 0.0f                                              // False: Do not offset the tile
             );
 
     // The y coordinates are multiplied by half the tile size because tiles in an isometric map are partially
     // overlapping.
-    float world_y = tile_point.y * (map->get_tile_height() / 2.0f);
+    float world_y = tile_point.y * (map.get_tile_height() / 2.0f);
 
     // Shift the world up half a tile to cover empty spaces:
-    world_y -= map->get_tile_height() / 2.0f;
+    world_y -= map.get_tile_height() / 2.0f;
 
     return SDL_FPoint{ world_x, world_y };
 }
 
-SDL_Point transform::world_pixels_to_world_tile(const SDL_FPoint& point) const
+SDL_FPoint transform::world_tile_to_world_pixels(const SDL_Point& tile_point) const
 {
-    if (!has_sanity()) return SDL_Point();
-
-    int y = static_cast<int>(point.y / (map->get_tile_height() / 2.0f));
-    int x = static_cast<int>(point.x / map->get_tile_width() +
-        y % 2 == 0
-        ? -static_cast<int>(map->get_tile_width()) / 2.0f
-        : 0.0f
-        );
-
-    // Increase precision of the tile point by doing a hit test of tiles in the general area:
-    SDL_Point tile_points[] = {
-        { x - 1, y - 1 },   // Top Left
-        { x + 1, y - 1 },   // Top Right
-        { x - 1, y + 1 },   // Bottom Left
-        { x + 1, y + 1 }    // Bottom Right
-    };
+    if (!has_sanity()) return SDL_FPoint();
 
-    for (const auto& tile_point : tile_points)
-    {
-        if (tile_hittest(tile_point, point))
-        {
-            return tile_point;
-        }
-    }
+    return tile_to_world_pixels(*map, tile_point);
+}
 
-    return SDL_Point{ x, y };
+// The conversions below check the transform's sanity once, through get_view(), an invalid view means it failed:
+
+SDL_Point transform::world_pixels_to_world_tile(const SDL_FPoint& point) const
+{
+    const view_transform view = get_view();
+    if (!view.is_valid()) return SDL_Point();
+
+    return view.world_to_tile(point);
 }
 
-SDL_FPoint transform::world_tile_to_viewport_pixels(const SDL_Point& tile_point) const
+SDL_FPoint transform::viewport_pixels_to_world_pixels(const SDL_FPoint& point) const
 {
-    if (!has_sanity()) return SDL_FPoint();
+    const view_transform view = get_view();
+    if (!view.is_valid()) return SDL_FPoint();
 
-    // Get this tile's pixel position relative to the entire map:
-    SDL_FPoint screen_point = world_tile_to_world_pixels(tile_point);
+    return view.viewport_to_world(point);
+}
 
-    // Convert the tile's pixel position to be relative to the top left of the camera's position:
-    screen_point.x = screen_point.x - main_camera->get_current_x() * map->get_tile_width();
-    screen_point.y = screen_point.y - main_camera->get_current_y() * (map->get_tile_height() / 2.0f);
+SDL_Point transform::viewport_pixels_to_world_tile(const SDL_FPoint& point) const
+{
+    const view_transform view = get_view();
+    if (!view.is_valid()) return SDL_Point();
 
-    // Adjust the x, y based on the current camera viewport and not assume the world is drawn starting at 0, 0
-    // pixels all of the time.
-    screen_point.x += main_camera->get_viewport_x();
-    screen_point.y += main_camera->get_viewport_y();
+    return view.viewport_to_tile(point);
+}
 
-    return screen_point;
+SDL_FPoint transform::world_tile_to_viewport_pixels(const SDL_Point& tile_point) const
+{
+    const view_transform view = get_view();
+    if (!view.is_valid()) return SDL_FPoint();
+
+    return view.tile_to_viewport(tile_point);
 }
 
 SDL_FPoint transform::world_pixels_to_viewport_pixels(const SDL_FPoint& point) const
@@ -126,7 +139,7 @@ SDL_FPoint transform::world_pixels_to_viewport_pixels(const SDL_FPoint& point) c
         static_cast<int>(main_camera->get_current_y())
     };
 
-    SDL_FPoint current_pixel_pos = world_tile_to_world_pixels(current_tile_pos);
+    SDL_FPoint current_pixel_pos = tile_to_world_pixels(*map, current_tile_pos);
 
     current_pixel_pos.x +=
         current_tile_pos.y % 2 == 0
@@ -141,14 +154,21 @@ SDL_FPoint transform::world_pixels_to_viewport_pixels(const SDL_FPoint& point) c
 
 bool transform::tile_hittest(const SDL_Point& tile_point, const SDL_FPoint& point) const
 {
-    const SDL_FPoint tile_viewport_point = world_tile_to_viewport_pixels(tile_point);
-    return tile_hittest_by_viewport(tile_viewport_point, point);
+    const view_transform view = get_view();
+    if (!view.is_valid()) return false;
+
+    return hittest_tile_diamond(view.tile_to_viewport(tile_point), point);
 }
 
 bool transform::tile_hittest_by_viewport(const SDL_FPoint& tile_viewport_point, const SDL_FPoint& point) const
 {
     if (!has_sanity()) return false;
 
+    return hittest_tile_diamond(tile_viewport_point, point);
+}
+
+bool transform::hittest_tile_diamond(const SDL_FPoint& tile_viewport_point, const SDL_FPoint& point) const
+{
     SDL_FPoint translated_point = SDL_FPoint{
         point.x - tile_viewport_point.x,
         point.y - tile_viewport_point.y
@@ -175,4 +195,77 @@ bool transform::tile_hittest_by_viewport(const SDL_FPoint& tile_viewport_point,
     }
 
     return false;
-}
\ No newline at end of file
+}
+
+visible_tile_span transform::get_visible_tile_span() const
+{
+    if (!has_sanity()) return visible_tile_span();
+
+    return find_visible_tile_span(map->get_image_bounds());
+}
+
+// The first and one past the last integer n where low < n < high, clamped to 0..limit:
+static void open_interval_to_range(double low, double high, unsigned limit, unsigned& first, unsigned& end)
+{
+    double first_value = std::clamp(std::floor(low) + 1.0, 0.0, static_cast<double>(limit));
+    double end_value = std::clamp(std::ceil(high), 0.0, static_cast<double>(limit));
+
+    first = static_cast<unsigned>(first_value);
+    end = std::max(first, static_cast<unsigned>(end_value));
+}
+
+visible_tile_span transform::get_visible_tile_span(const SDL_FRect& tile_bounds) const
+{
+    if (!has_sanity()) return visible_tile_span();
+
+    return find_visible_tile_span(tile_bounds);
+}
+
+visible_tile_span transform::find_visible_tile_span(const SDL_FRect& tile_bounds) const
+{
+    // This solves world_tile_to_viewport_pixels for the tiles whose bounds overlap the viewport. Relative to the
+    // viewport, the tile x, y is drawn at:
+    //
+    //  x * tile_width - stagger - camera_x * tile_width        (stagger is half a tile on even rows, otherwise 0)
+    //  (y - 1 - camera_y) * tile_height / 2
+    //
+    // A tile is visible when the right of its bounds is past the left of the viewport and the left of its bounds is
+    // before the right of the viewport (and the same for top and bottom), which gives an open interval for each axis.
+    const double tile_width = map->get_tile_width();
+    const double half_tile_height = map->get_tile_height() / 2.0;
+    const double camera_x = main_camera->get_current_x();
+    const double camera_y = main_camera->get_current_y();
+    const double viewport_width = main_camera->get_width();
+    const double viewport_height = main_camera->get_height();
+
+    const double bounds_left = tile_bounds.x;
+    const double bounds_top = tile_bounds.y;
+    const double bounds_right = static_cast<double>(tile_bounds.x) + tile_bounds.w;
+    const double bounds_bottom = static_cast<double>(tile_bounds.y) + tile_bounds.h;
+
+    visible_tile_span span;
+
+    if (tile_width <= 0.0 || half_tile_height <= 0.0) return span;
+
+    open_interval_to_range(
+        camera_y + 1.0 - bounds_bottom / half_tile_height,
+        camera_y + 1.0 + (viewport_height - bounds_top) / half_tile_height,
+        map->get_map_height(), span.first_y, span.end_y
+    );
+
+    const double even_stagger = tile_width / 2.0;
+
+    open_interval_to_range(
+        camera_x + (even_stagger - bounds_right) / tile_width,
+        camera_x + (viewport_width + even_stagger - bounds_left) / tile_width,
+        map->get_map_width(), span.even_first_x, span.even_end_x
+    );
+
+    open_interval_to_range(
+        camera_x - bounds_right / tile_width,
+        camera_x + (viewport_width - bounds_left) / tile_width,
+        map->get_map_width(), span.odd_first_x, span.odd_end_x
+    );
+
+    return span;
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include "camera.h"
 #include "tile_map.h"
+#include "visible_tile_span.h"
+#include "view_transform.h"
 
 namespace isometric {
 
@@ -10,6 +12,10 @@ namespace isometric {
         std::shared_ptr<camera> main_camera;
         std::shared_ptr<tile_map> map;
 
+        // The work of tile_hittest_by_viewport and get_visible_tile_span, for callers that checked sanity already:
+        bool hittest_tile_diamond(const SDL_FPoint& tile_viewport_point, const SDL_FPoint& point) const;
+        visible_tile_span find_visible_tile_span(const SDL_FRect& tile_bounds) const;
+
     public:
         transform(std::shared_ptr<camera> camera, std::shared_ptr<tile_map> map);
 
@@ -21,6 +27,12 @@ namespace isometric {
 
         bool has_sanity() const;
 
+        /// <summary>
+        /// Takes a snapshot of the transform for the current camera position, for converting many points at once
+        /// </summary>
+        /// <returns>The snapshot, which isn't valid if the transform lacks sanity</returns>
+        view_transform get_view() const;
+
         /// <summary>
         /// Converts a world tile position (in tile coordinates) to a world based pixel position. The pixel based 
         /// coordinates starts at 0, 0 relative to the top left of the whole map.
@@ -37,6 +49,22 @@ namespace isometric {
         /// <returns>The tile position of a tile starting at 0, 0 relative to the entire world</returns>
         SDL_Point world_pixels_to_world_tile(const SDL_FPoint& point) const;
 
+        /// <summary>
+        /// Converts a viewport pixel position to a world based pixel position for the current camera position. This
+        /// is the inverse of how world_tile_to_viewport_pixels positions tiles.
+        /// </summary>
+        /// <param name="point">The pixel position relative to the top left of the camera viewport</param>
+        /// <returns>The pixel position relative to the top left of the whole map</returns>
+        SDL_FPoint viewport_pixels_to_world_pixels(const SDL_FPoint& point) const;
+
+        /// <summary>
+        /// Finds the tile under a viewport pixel position, such as the mouse cursor. This is a constant time
+        /// calculation no matter how many tiles are visible.
+        /// </summary>
+        /// <param name="point">The pixel position relative to the top left of the camera viewport</param>
+        /// <returns>The tile position, which may be outside of the map</returns>
+        SDL_Point viewport_pixels_to_world_tile(const SDL_FPoint& point) const;
+
         /// <summary>
         /// Converts a world tile position (in tile coordinates) to a viewport pixel position. This is where the tile
         /// should be rendered to the viewport based on the top left of what is visible on the screen.
@@ -69,6 +97,20 @@ namespace isometric {
         /// <param name="point">The pixel coordinate to test</param>
         /// <returns>True if point is inside the tile</returns>
         bool tile_hittest_by_viewport(const SDL_FPoint& tile_viewport_point, const SDL_FPoint& point) const;
+
+        /// <summary>
+        /// Gets the exact tiles that can be seen through the camera's viewport, taking into account images that reach
+        /// outside of their tile (see tile_map::get_image_bounds)
+        /// </summary>
+        /// <returns>The visible tiles, clamped to the map</returns>
+        visible_tile_span get_visible_tile_span() const;
+
+        /// <summary>
+        /// Gets the tiles that have any part of tile_bounds within the camera's viewport
+        /// </summary>
+        /// <param name="tile_bounds">The area drawn for every tile, in pixels relative to the tile's position</param>
+        /// <returns>The visible tiles, clamped to the map</returns>
+        visible_tile_span get_visible_tile_span(const SDL_FRect& tile_bounds) const;
     };
 
 }
@@ -0,0 +1,136 @@
+#include "view_transform.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ISOMETRIC_VIEW_TRANSFORM_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define ISOMETRIC_VIEW_TRANSFORM_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace isometric;
+
+static_assert(sizeof(SDL_Point) == sizeof(int) * 2, "Batch conversions treat SDL_Point arrays as int pairs");
+static_assert(sizeof(SDL_FPoint) == sizeof(float) * 2, "Batch conversions treat SDL_FPoint arrays as float pairs");
+
+void view_transform::get_matrix(float matrix[6]) const
+{
+    matrix[0] = tile_width;
+    matrix[1] = 0.0f;
+    matrix[2] = tile_x;
+    matrix[3] = 0.0f;
+    matrix[4] = half_tile_height;
+    matrix[5] = tile_y;
+}
+
+SDL_Point view_transform::world_to_tile(const SDL_FPoint& point) const
+{
+    if (!valid) return SDL_Point();
+
+    // Odd rows aren't staggered, so their tiles line up in a grid of tile sized cells with one diamond in each cell
+    // (odd row y starts (y - 1) / 2 tile heights down, see transform::world_tile_to_world_pixels):
+    const float cell_x = std::floor(point.x / tile_width);
+    const float cell_y = std::floor(point.y / tile_height);
+    const int x = static_cast<int>(cell_x);
+    const int odd_y = static_cast<int>(cell_y) * 2 + 1;
+
+    // Position within the cell relative to its centre, scaled so that the diamond is where |u| + |v| <= 1:
+    const float u = (point.x - cell_x * tile_width) / (tile_width / 2.0f) - 1.0f;
+    const float v = (point.y - cell_y * tile_height) / half_tile_height - 1.0f;
+
+    if (std::abs(u) + std::abs(v) <= 1.0f) return SDL_Point{ x, odd_y };
+
+    // Otherwise the point is in one of the cell's corners, each of which is a quarter of an even row tile. The
+    // staggered even row tiles are centred on the cell's left and right edges, and its top and bottom edges:
+    return SDL_Point{
+        u < 0.0f ? x : x + 1,
+        v < 0.0f ? odd_y - 1 : odd_y + 1
+    };
+}
+
+void view_transform::tiles_to_viewport(const SDL_Point* tile_points, SDL_FPoint* results, size_t count) const
+{
+    size_t index = 0;
+
+    // Two points (x, y, x, y) at a time:
+#if ISOMETRIC_VIEW_TRANSFORM_SSE2
+    const __m128 scale = _mm_setr_ps(tile_width, half_tile_height, tile_width, half_tile_height);
+    const __m128 translate = _mm_setr_ps(tile_x, tile_y, tile_x, tile_y);
+    const __m128 stagger = _mm_setr_ps(even_row_stagger, 0.0f, even_row_stagger, 0.0f);
+    const __m128i odd_bit = _mm_setr_epi32(0, 1, 0, 1);
+
+    for (; index + 2 <= count; index += 2)
+    {
+        const __m128i tile = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile_points + index));
+
+        // All bits set in both lanes of a point if its y is even, then used to pick the stagger for its x lane:
+        __m128i even = _mm_cmpeq_epi32(_mm_and_si128(tile, odd_bit), _mm_setzero_si128());
+        even = _mm_shuffle_epi32(even, _MM_SHUFFLE(3, 3, 1, 1));
+
+        __m128 pixels = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(tile), scale), translate);
+        pixels = _mm_add_ps(pixels, _mm_and_ps(_mm_castsi128_ps(even), stagger));
+
+        _mm_storeu_ps(reinterpret_cast<float*>(results + index), pixels);
+    }
+#elif ISOMETRIC_VIEW_TRANSFORM_NEON
+    const float scale_lanes[] = { tile_width, half_tile_height, tile_width, half_tile_height };
+    const float translate_lanes[] = { tile_x, tile_y, tile_x, tile_y };
+    const float stagger_lanes[] = { even_row_stagger, 0.0f, even_row_stagger, 0.0f };
+    const int32_t odd_bit_lanes[] = { 0, 1, 0, 1 };
+
+    const float32x4_t scale = vld1q_f32(scale_lanes);
+    const float32x4_t translate = vld1q_f32(translate_lanes);
+    const float32x4_t stagger = vld1q_f32(stagger_lanes);
+    const int32x4_t odd_bit = vld1q_s32(odd_bit_lanes);
+
+    for (; index + 2 <= count; index += 2)
+    {
+        const int32x4_t tile = vld1q_s32(reinterpret_cast<const int32_t*>(tile_points + index));
+
+        // All bits set in both lanes of a point if its y is even, then used to pick the stagger for its x lane:
+        uint32x4_t even = vceqq_s32(vandq_s32(tile, odd_bit), vdupq_n_s32(0));
+        even = vtrn2q_u32(even, even);
+
+        float32x4_t pixels = vmlaq_f32(translate, vcvtq_f32_s32(tile), scale);
+        pixels = vaddq_f32(pixels, vreinterpretq_f32_u32(vandq_u32(even, vreinterpretq_u32_f32(stagger))));
+
+        vst1q_f32(reinterpret_cast<float*>(results + index), pixels);
+    }
+#endif
+
+    for (; index < count; index++)
+    {
+        results[index] = tile_to_viewport(tile_points[index]);
+    }
+}
+
+void view_transform::world_to_viewport(const SDL_FPoint* points, SDL_FPoint* results, size_t count) const
+{
+    size_t index = 0;
+
+    // Two points (x, y, x, y) at a time:
+#if ISOMETRIC_VIEW_TRANSFORM_SSE2
+    const __m128 translate = _mm_setr_ps(world_x, world_y, world_x, world_y);
+
+    for (; index + 2 <= count; index += 2)
+    {
+        const __m128 point = _mm_loadu_ps(reinterpret_cast<const float*>(points + index));
+        _mm_storeu_ps(reinterpret_cast<float*>(results + index), _mm_add_ps(point, translate));
+    }
+#elif ISOMETRIC_VIEW_TRANSFORM_NEON
+    const float translate_lanes[] = { world_x, world_y, world_x, world_y };
+    const float32x4_t translate = vld1q_f32(translate_lanes);
+
+    for (; index + 2 <= count; index += 2)
+    {
+        const float32x4_t point = vld1q_f32(reinterpret_cast<const float*>(points + index));
+        vst1q_f32(reinterpret_cast<float*>(results + index), vaddq_f32(point, translate));
+    }
+#endif
+
+    for (; index < count; index++)
+    {
+        results[index] = world_to_viewport(points[index]);
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <SDL.h>
+
+namespace isometric {
+
+    /// <summary>
+    /// A snapshot of a transform for one camera position, taken with transform::get_view(). Converting a point is a
+    /// multiply and an add with no checks or pointer chasing, and the batch functions convert whole arrays of points
+    /// with SIMD (SSE2 on x86, NEON on ARM). Take a new snapshot whenever the camera or map changes, such as once per
+    /// frame.
+    ///
+    /// Tiles go to the viewport through the affine matrix
+    ///
+    ///  | tile_width  0                  translate_x |
+    ///  | 0           tile_height / 2    translate_y |
+    ///
+    /// after which tiles on even rows are moved by even_row_stagger, world pixels only need the translation.
+    /// </summary>
+    class view_transform
+    {
+        friend class transform;
+    private:
+        float tile_width = 0.0f;
+        float tile_height = 0.0f;
+        float half_tile_height = 0.0f;
+        float even_row_stagger = 0.0f;      // Added to the x of tiles on even rows
+        float world_x = 0.0f;               // World pixels to viewport pixels translation
+        float world_y = 0.0f;
+        float tile_x = 0.0f;                // Tiles to viewport pixels translation
+        float tile_y = 0.0f;
+        bool valid = false;
+
+    public:
+        /// <returns>False for the snapshot of a transform without a camera or map, it converts everything to 0, 0</returns>
+        bool is_valid() const { return valid; }
+
+        /// <summary>
+        /// Gets the affine part of the tile to viewport conversion (see the class summary)
+        /// </summary>
+        /// <param name="matrix">Set to the matrix rows, { m00, m01, m02, m10, m11, m12 }</param>
+        void get_matrix(float matrix[6]) const;
+
+        float get_even_row_stagger() const { return even_row_stagger; }
+
+        /// <summary>
+        /// Same as transform::world_tile_to_viewport_pixels
+        /// </summary>
+        SDL_FPoint tile_to_viewport(const SDL_Point& tile_point) const
+        {
+            return SDL_FPoint{
+                tile_point.x * tile_width + tile_x + ((tile_point.y & 1) == 0 ? even_row_stagger : 0.0f),
+                tile_point.y * half_tile_height + tile_y
+            };
+        }
+
+        SDL_FPoint world_to_viewport(const SDL_FPoint& point) const
+        {
+            return SDL_FPoint{ point.x + world_x, point.y + world_y };
+        }
+
+        /// <summary>
+        /// Same as transform::viewport_pixels_to_world_pixels
+        /// </summary>
+        SDL_FPoint viewport_to_world(const SDL_FPoint& point) const
+        {
+            return SDL_FPoint{ point.x - world_x, point.y - world_y };
+        }
+
+        /// <summary>
+        /// Same as transform::world_pixels_to_world_tile
+        /// </summary>
+        SDL_Point world_to_tile(const SDL_FPoint& point) const;
+
+        /// <summary>
+        /// Same as transform::viewport_pixels_to_world_tile
+        /// </summary>
+        SDL_Point viewport_to_tile(const SDL_FPoint& point) const
+        {
+            return world_to_tile(viewport_to_world(point));
+        }
+
+        /// <summary>
+        /// Convert an array of tile positions to viewport pixels, tile_points and results may not overlap
+        /// </summary>
+        void tiles_to_viewport(const SDL_Point* tile_points, SDL_FPoint* results, size_t count) const;
+
+        /// <summary>
+        /// Convert an array of world pixel positions to viewport pixels, points and results may be the same array
+        /// </summary>
+        void world_to_viewport(const SDL_FPoint* points, SDL_FPoint* results, size_t count) const;
+    };
+
+}
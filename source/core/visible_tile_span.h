@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+
+namespace isometric {
+
+    /// <summary>
+    /// The tiles of a map that can be seen through a viewport, as exact integer ranges. Every tile inside the span
+    /// has part of its image within the viewport and every tile outside of it has none, so code that walks the span
+    /// (rendering, picking, streaming in chunks) never visits a tile that can't be seen.
+    ///
+    /// Rows of a staggered isometric map alternate between two horizontal offsets, so a span is a range of rows plus
+    /// one column range for even rows and one for odd rows.
+    /// </summary>
+    struct visible_tile_span
+    {
+        unsigned first_y = 0;
+        unsigned end_y = 0;         // One past the last visible row
+
+        unsigned even_first_x = 0;
+        unsigned even_end_x = 0;    // One past the last visible column of even rows
+        unsigned odd_first_x = 0;
+        unsigned odd_end_x = 0;     // One past the last visible column of odd rows
+
+        /// <summary>
+        /// A single row of the span, tiles first_x up to (not including) end_x are visible
+        /// </summary>
+        struct row
+        {
+            unsigned y = 0;
+            unsigned first_x = 0;
+            unsigned end_x = 0;
+
+            unsigned get_tile_count() const { return end_x > first_x ? end_x - first_x : 0; }
+        };
+
+        row get_row(unsigned y) const
+        {
+            return y % 2 == 0
+                ? row{ y, even_first_x, even_end_x }
+                : row{ y, odd_first_x, odd_end_x };
+        }
+
+        bool is_empty() const
+        {
+            return get_tile_count() == 0;
+        }
+
+        /// <returns>True if the tile at x, y is visible</returns>
+        bool contains(unsigned x, unsigned y) const
+        {
+            if (y < first_y || y >= end_y) return false;
+
+            row span_row = get_row(y);
+            return x >= span_row.first_x && x < span_row.end_x;
+        }
+
+        /// <returns>The exact number of visible tiles</returns>
+        unsigned long long get_tile_count() const
+        {
+            unsigned long long tile_count = 0;
+
+            for (unsigned y = first_y; y < end_y; y++)
+            {
+                tile_count += get_row(y).get_tile_count();
+            }
+
+            return tile_count;
+        }
+
+        /// <summary>
+        /// Iterates the rows of the span in order from top to bottom, for use in range based for loops
+        /// </summary>
+        class row_iterator
+        {
+        private:
+            const visible_tile_span* span = nullptr;
+            unsigned y = 0;
+
+        public:
+            row_iterator(const visible_tile_span* span, unsigned y) : span(span), y(y) {}
+
+            row operator*() const { return span->get_row(y); }
+            row_iterator& operator++() { y++; return *this; }
+            bool operator!=(const row_iterator& other) const { return y != other.y; }
+        };
+
+        row_iterator begin() const { return row_iterator(this, first_y); }
+        row_iterator end() const { return row_iterator(this, std::max(first_y, end_y)); }
+    };
+
+}
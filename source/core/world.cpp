@@ -1,7 +1,11 @@
 #include <SDL.h>
 #include "world.h"
 #include "input.h"
+#include "../tools/profiler.h"
+#include "../rendering/render_layer.h"
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 
 using namespace isometric;
 
@@ -18,6 +22,26 @@ world::world(std::shared_ptr<tile_map> map, std::shared_ptr<camera> main_camera)
     {
         cameras.push_back(main_camera);
     }
+
+    if (map != nullptr)
+    {
+        object_grid.create(map->get_map_width(), map->get_map_height());
+    }
+}
+
+world::~world()
+{
+    // Objects can outlive the world, make sure they no longer report their movement to it:
+    for (const auto& obj : objects)
+    {
+        const uint32_t index = entities.get_index(obj->entity_handle);
+        obj->position = entities.get_position(index);
+        obj->velocity = entities.get_velocity(index);
+        obj->entity_handle = entity();
+
+        object_grid.remove(obj.get());
+        obj->owner = nullptr;
+    }
 }
 
 std::shared_ptr<camera> world::get_main_camera() const
@@ -32,142 +56,503 @@ std::shared_ptr<camera> world::get_main_camera() const
 
 void world::update(double delta_time)
 {
-    transform.set_camera(get_main_camera());
+    tools::profile_zone zone("world::update");
+    auto camera = get_main_camera();
+    transform.set_camera(camera);
     transform.set_map(map);
+    view = camera ? transform.get_view() : view_transform();
+
+    // Select the tile under the mouse cursor, if the cursor is over the map:
+    if (camera)
+    {
+        const SDL_FPoint mouse_position = input::mouse_position();
+        const SDL_FRect camera_viewport = {
+            static_cast<float>(camera->get_viewport_x()),
+            static_cast<float>(camera->get_viewport_y()),
+            static_cast<float>(camera->get_width()),
+            static_cast<float>(camera->get_height())
+        };
+
+        if (mouse_position.x >= camera_viewport.x && mouse_position.x < camera_viewport.x + camera_viewport.w &&
+            mouse_position.y >= camera_viewport.y && mouse_position.y < camera_viewport.y + camera_viewport.h)
+        {
+            SDL_Point tile_point = view.viewport_to_tile(mouse_position);
+
+            if (tile_point.x >= 0 && tile_point.y >= 0 &&
+                map->is_inside(static_cast<unsigned>(tile_point.x), static_cast<unsigned>(tile_point.y)))
+            {
+                set_selection(tile_point);
+            }
+        }
+    }
+
+    // Move every entity by its velocity, game objects that moved need the object grid to know where they are now:
+    entities.integrate(delta_time);
+
+    entities.for_each(entity_moved | entity_moving, [this](uint32_t index) {
+        if (game_object* obj = entities.get_object(index))
+        {
+            object_grid.move(obj, view.world_to_tile(entities.get_position(index)));
+        }
+    });
+
+    entities.clear_moved();
 
     update_called = true;
 }
 
-void world::render(SDL_Renderer* renderer, double delta_time)
+void world::sync()
 {
+    tools::profile_zone zone("world::sync");
+
     if (!update_called)
     {
         std::cout << "WARN: Update wasn't called before the world was rendered! Transform may be invalid as a result." << std::endl;
     }
 
-    unsigned long long render_tile_count = 0;
-    unsigned long long iterated_tile_count = 0;
+    // Objects removed since the last frame can't still be in the middle of being drawn, so they can be released now:
+    removed_objects.clear();
 
     auto camera = get_main_camera();
-    if (!camera) return; // No point in rendering if there is no camera
+    frame.has_camera = camera != nullptr;
 
-    SDL_Rect camera_viewport = {
-        static_cast<int>(camera->get_viewport_x()),
-        static_cast<int>(camera->get_viewport_y()),
-        static_cast<int>(camera->get_width()),
-        static_cast<int>(camera->get_height())
-    };
+    if (camera)
+    {
+        transform.set_camera(camera);
+        transform.set_map(map);
+
+        // Every tile, chunk and entity on the screen is positioned through one snapshot of the transform. Only the
+        // tiles that can actually be seen are visited, including tiles below the viewport whose tall images reach
+        // up into it:
+        frame.view = transform.get_view();
+        frame.span = transform.get_visible_tile_span();
+        frame.viewport = SDL_Rect{
+            static_cast<int>(camera->get_viewport_x()),
+            static_cast<int>(camera->get_viewport_y()),
+            static_cast<int>(camera->get_width()),
+            static_cast<int>(camera->get_height())
+        };
+    }
+    else
+    {
+        frame.span = visible_tile_span();
+    }
+
+    frame.selection = selected_world_tile;
+    frame.has_selection = has_selection();
+
+    // Objects are sorted into buckets by the row of tiles they're on, then each bucket is drawn after its row of tiles
+    // so that tiles in front of an object (on the rows below it) are drawn over it:
+    collect_visible_objects(frame.span);
+
+    // Signal update call checking, after rendering update() will need to be called again. This is primarily for 
+    // warning the developer about not calling update() before render()
+    update_called = false;
+}
+
+void world::render(SDL_Renderer* renderer, double delta_time)
+{
+    sync();
+    render_frame(renderer, delta_time);
+}
+
+void world::render_frame(SDL_Renderer* renderer, double delta_time)
+{
+    if (!frame.has_camera) return; // No point in rendering if there is no camera
+
+    tools::profile_zone zone("world::render_frame");
+
+    const visible_tile_span& span = frame.span;
+    const unsigned layer_count = map->get_layer_count();
+    layer_runs.resize(layer_count);
+
+    // Static layers that are underneath every dynamic layer are drawn from pre-rendered chunk textures, the rest of
+    // the layers are drawn tile by tile on top of them. This has to happen before anything else is drawn (and before
+    // clipping) as it may need to redraw chunk textures:
+    unsigned cached_layer_count = 0;
+    while (cached_layer_count < layer_count && map->get_layer(cached_layer_count).is_static)
+    {
+        cached_layer_count++;
+    }
+
+    if (cached_layer_count > 0)
+    {
+        tools::profile_zone chunk_zone("world::add_cached_chunks");
+
+        if (!add_cached_chunks(renderer, span, cached_layer_count))
+        {
+            tile_batch.clear();
+            cached_layer_count = 0;
+        }
+    }
 
     // Clip the viewport area so that the diamond edges of the tile map are instead straight lines:
-    SDL_RenderSetClipRect(renderer, &camera_viewport);
+    rendering::render_layer::set_clip_rect(renderer, &frame.viewport);
+
+    // If every layer came from the chunk textures, only the selection is left to draw and no tiles are visited:
+    const bool draw_tile_layers = cached_layer_count < layer_count;
+
+    if (!draw_tile_layers && frame.has_selection &&
+        span.contains(static_cast<unsigned>(frame.selection.x), static_cast<unsigned>(frame.selection.y)))
+    {
+        add_selection(frame.view.tile_to_viewport(frame.selection));
+    }
 
-    unsigned max_tiles_horiz = static_cast<unsigned>(
-        /* Add the current camera position */           camera->get_current_x() +
-        /* Pixel width of the camera + 1 column */      static_cast<float>(camera->get_width() + map->get_tile_width()) /
-        /* Number of half-sized tiles that can fit */   (map->get_tile_width() / 2.0f) + 1);
+    {
+        tools::profile_zone rows_zone("world::draw_rows");
 
-    unsigned max_tiles_vert = static_cast<unsigned>(
-        /* Add the current camera position */           camera->get_current_y() +
-        /* Pixel height of the camera + 1 row */        static_cast<float>(camera->get_height() + map->get_tile_height()) /
-        /* Number of half-sized tiles that can fit */   (map->get_tile_height() / 2.0f) + 1);
+        // Images that stay within their tile (the ground) can't cover anything on the rows above them, so every row of
+        // them is drawn first. Only the images that reach outside of their tile are drawn in between the rows of
+        // objects, as they can cover objects on the rows above and be covered by objects on the rows below:
+        raised_tiles.clear();
+        raised_row_ends.clear();
 
-    max_tiles_horiz = std::min(max_tiles_horiz, map->get_map_width());
-    max_tiles_vert = std::min(max_tiles_vert, map->get_map_height());
+        for (const visible_tile_span::row row : span)
+        {
+            if (draw_tile_layers) add_row_tiles(row, cached_layer_count);
+            raised_row_ends.push_back(raised_tiles.size());
+        }
+
+        draw_object_row(renderer, 0, delta_time); // Objects on rows above the visible tiles
+
+        for (size_t row_index = 0, raised_index = 0; row_index < raised_row_ends.size(); row_index++)
+        {
+            for (; raised_index < raised_row_ends[row_index]; raised_index++)
+            {
+                const raised_tile& tile = raised_tiles[raised_index];
+
+                tile_batch.add_quad(
+                    tile.image_draw->texture,
+                    tile.image_draw->source_rect,
+                    tile.image_draw->texture_size,
+                    tile.dest_rect,
+                    SDL_Color{ 255, 255, 255, tile.opacity }
+                );
+            }
+
+            draw_object_row(renderer, row_index + 1, delta_time);
+        }
+
+        // Objects on rows below the visible tiles:
+        draw_object_row(renderer, span.is_empty() ? 1 : static_cast<size_t>(span.end_y - span.first_y) + 1, delta_time);
+
+        // Draw whatever tiles are left after the last row of objects:
+        tile_batch.submit(renderer);
+    }
 
-    for (float tile_y = camera->get_current_y(); tile_y < max_tiles_vert; tile_y++)
+    // Reset clipping so that future rendering isn't affected:
+    rendering::render_layer::set_clip_rect(renderer, nullptr);
+}
+
+void world::add_row_tiles(const visible_tile_span::row& row, unsigned cached_layer_count)
+{
+    const unsigned map_y = row.y;
+    const unsigned layer_count = map->get_layer_count();
+
+    // Tiles are in tile coordinates, to render they're converted to pixel coordinates relative to the viewport
+    // (screen). The whole row is converted at once:
+    row_tile_points.clear();
+    for (unsigned map_x = row.first_x; map_x < row.end_x; map_x++)
+    {
+        row_tile_points.push_back(SDL_Point{ static_cast<int>(map_x), static_cast<int>(map_y) });
+    }
+
+    row_screen_points.resize(row_tile_points.size());
+    frame.view.tiles_to_viewport(row_tile_points.data(), row_screen_points.data(), row_tile_points.size());
+
+    // Walk the row a chunk at a time, within a chunk every layer's image indices are contiguous so each layer's run is
+    // fetched once and then scanned:
+    for (unsigned run_x = row.first_x, run_end_x = 0; run_x < row.end_x; run_x = run_end_x)
     {
-        for (float tile_x = camera->get_current_x(); tile_x < max_tiles_horiz; tile_x++)
+        run_end_x = std::min((run_x | (tile_map::chunk_size - 1)) + 1, row.end_x);
+
+        for (unsigned layer_id = cached_layer_count; layer_id < layer_count; layer_id++)
+        {
+            layer_runs[layer_id] = map->get_layer(layer_id).visible
+                ? map->get_layer_run(layer_id, run_x, map_y)
+                : nullptr;
+        }
+
+        for (unsigned map_x = run_x; map_x < run_end_x; map_x++)
         {
-            iterated_tile_count++;
+            const SDL_Point& tile_point = row_tile_points[map_x - row.first_x];
+            const SDL_FPoint& screen_pos = row_screen_points[map_x - row.first_x];
+
+            // The selected tile is picked in update():
+            const bool is_selected = tile_point.x == frame.selection.x && tile_point.y == frame.selection.y;
 
-            tile* current_tile = map->get_tile((unsigned)tile_x, (unsigned)tile_y);
-            SDL_Point tile_point{ static_cast<int>(tile_x), static_cast<int>(tile_y) };
-            std::shared_ptr<tile_image> current_image = nullptr;
-            bool is_selected = false;
+            // The selection goes on top of the first layer, which may have come from the chunk textures:
+            if (is_selected && cached_layer_count > 0) add_selection(screen_pos);
 
-            // Render image (if there is one) for every layer:
-            for (unsigned layer_id = 0; layer_id < map->get_layers().size(); layer_id++)
+            // Render image (if there is one) for every layer that isn't cached:
+            for (unsigned layer_id = cached_layer_count; layer_id < layer_count; layer_id++)
             {
-                if (current_tile && current_tile->has_image(layer_id))
-                {
-                    // If the tile isn't empty, get it's image:
-                    current_image = map->get_image(current_tile->get_image_id(layer_id));
-                }
-                else if ((!current_tile || !current_tile->has_image(layer_id)) && map->layer_has_default_images(layer_id))
-                {
-                    // If the tile is empty, attempt to get a default image for the tile and set it so that it's
-                    // remembered if this tile comes back into view later.
-                    current_image = map->get_image(map->get_random_layer_default_image(layer_id));
-                    current_tile->set_image_id(layer_id, current_image->get_image_id());
-                }
-                else
-                {
-                    continue; // Tile is definitely empty
-                }
+                const tile_layer& layer = map->get_layer(layer_id);
+                if (!layer.visible) continue;
 
-                // Tiles are currently in tile coordinates, to render convert it to pixel coordinates relative
-                // to the viewport (screen):
-                SDL_FPoint screen_pos = transform.world_tile_to_viewport_pixels(tile_point);
+                tile_image_index image_index =
+                    layer_runs[layer_id]
+                    ? layer_runs[layer_id][map_x - run_x]
+                    : empty_tile_image;
 
-                if (current_image != nullptr && current_tile && current_tile->has_image(layer_id))
+                if (image_index == empty_tile_image)
                 {
-                    SDL_RenderCopyF(
-                        renderer,
-                        current_image->get_texture(),
-                        current_image->get_source_rect(),   // Where the tile is in the source image
-                        current_image->get_dest_rect(
-                            screen_pos.x, screen_pos.y,     // Where to actually draw the tile on the screen
-                            map->get_tile_height()          // The tile height is used to bottom align tile images
-                        )
-                    );
-
-                    // For metrics & logging, how many tiles have been rendered?
-                    render_tile_count++;
+                    // If the tile is empty, use the layer's default image for it. Defaults are a pure function of the
+                    // tile's position so nothing is written back to the map:
+                    image_index = static_cast<tile_image_index>(map->get_layer_default_image(map_x, map_y, layer_id));
+                    if (image_index == empty_tile_image) continue; // Tile is definitely empty
                 }
 
-                // Set the currently selected tile based on the position of the mouse cursor:
-                if (transform.tile_hittest_by_viewport(screen_pos, input::mouse_position()))
+                const tile_image_draw* image_draw = map->get_image_draw(image_index);
+
+                if (image_draw != nullptr)
                 {
-                    set_selection(tile_point);
-                    is_selected = true;
+                    // Where to actually draw the tile on the screen, the draw record's offset bottom aligns it:
+                    SDL_FRect dest_rect = image_draw->dest_rect;
+                    dest_rect.x += screen_pos.x;
+                    dest_rect.y += screen_pos.y;
+
+                    if (image_draw->within_tile)
+                    {
+                        tile_batch.add_quad(
+                            image_draw->texture,
+                            image_draw->source_rect,
+                            image_draw->texture_size,
+                            dest_rect,
+                            SDL_Color{ 255, 255, 255, layer.opacity }
+                        );
+                    }
+                    else
+                    {
+                        raised_tiles.push_back(raised_tile{ image_draw, dest_rect, layer.opacity });
+                    }
                 }
 
                 // Render the selection tile if the current tile is selected and this is the first layer:
-                if (layer_id == 0 && is_selected && map->has_selection_image())
-                {
-                    auto selection_image = map->get_selection_image();
-
-                    // The selection tile image should be rendered as semi-transparent
-                    SDL_SetTextureAlphaMod(selection_image->get_texture(), 90);
-
-                    SDL_RenderCopyF(
-                        renderer,
-                        selection_image->get_texture(),
-                        selection_image->get_source_rect(),
-                        selection_image->get_dest_rect(
-                            screen_pos.x, screen_pos.y,
-                            map->get_tile_height()
-                        )
-                    );
-
-                    SDL_SetTextureAlphaMod(selection_image->get_texture(), 255);
-                }
+                if (layer_id == 0 && is_selected) add_selection(screen_pos);
             }
         }
     }
+}
 
-    // Render game objects:
-    for (const auto& obj : objects)
+void world::collect_visible_objects(const visible_tile_span& span)
+{
+    tools::profile_zone zone("world::collect_visible_objects");
+
+    // One bucket per visible row, plus one for the rows above them and one for the rows below them:
+    const size_t row_count = span.end_y > span.first_y ? span.end_y - span.first_y : 0;
+    if (object_rows.size() < row_count + 2) object_rows.resize(row_count + 2);
+
+    for (auto& object_row : object_rows)
     {
-        if (obj) obj->on_render(renderer, delta_time);
+        object_row.clear();
     }
 
-    // Reset clipping so that future rendering isn't affected:
-    SDL_RenderSetClipRect(renderer, nullptr);
+    if (entity_rows.size() < row_count + 2) entity_rows.resize(row_count + 2);
 
-    // Signal update call checking, after rendering update() will need to be called again. This is primarily for 
-    // warning the developer about not calling update() before render()
-    update_called = false;
+    for (auto& entity_row : entity_rows)
+    {
+        entity_row.clear();
+    }
+
+    if (span.is_empty()) return;
+
+    auto row_index_of = [&](int tile_y) {
+        return
+            tile_y < static_cast<int>(span.first_y) ? 0 :
+            tile_y >= static_cast<int>(span.end_y) ? row_count + 1 :
+            static_cast<size_t>(tile_y - static_cast<int>(span.first_y)) + 1;
+    };
+
+    // Entity sprites are drawn centred on the entity's position, so an entity can be seen if its position is within
+    // the map's image bounds (moved by half a tile) of the viewport:
+    const float half_tile_width = map->get_tile_width() / 2.0f;
+    const float half_tile_height = map->get_tile_height() / 2.0f;
+    const SDL_FRect& image_bounds = map->get_image_bounds();
+    const SDL_FPoint view_origin = frame.view.viewport_to_world(SDL_FPoint{
+        static_cast<float>(frame.viewport.x),
+        static_cast<float>(frame.viewport.y)
+    });
+
+    visible_entities.clear();
+    entities.cull(
+        SDL_FRect{
+            view_origin.x + half_tile_width - image_bounds.x - image_bounds.w,
+            view_origin.y + half_tile_height - image_bounds.y - image_bounds.h,
+            frame.viewport.w + image_bounds.w,
+            frame.viewport.h + image_bounds.h
+        },
+        visible_entities
+    );
+
+    // Copy what's needed to draw the visible entities, so drawing them doesn't touch the entity store. The positions
+    // are converted to the viewport all at once, the rows refer to entities by their place in these arrays:
+    visible_entity_points.resize(visible_entities.size());
+    visible_entity_sprites.resize(visible_entities.size());
+
+    for (size_t visible_index = 0; visible_index < visible_entities.size(); visible_index++)
+    {
+        const SDL_FPoint& position = entities.get_position(visible_entities[visible_index]);
+        visible_entity_points[visible_index] = position;
+        visible_entity_sprites[visible_index] = entities.get_sprite(visible_entities[visible_index]);
+
+        const int tile_y = frame.view.world_to_tile(position).y;
+        entity_rows[row_index_of(tile_y)].push_back(static_cast<uint32_t>(visible_index));
+    }
+
+    frame.view.world_to_viewport(
+        visible_entity_points.data(), visible_entity_points.data(), visible_entity_points.size()
+    );
+
+    // Objects are indexed by the tile their position is on, so an extra cell around the visible tiles catches objects
+    // that reach onto the screen from just outside of it:
+    const int first_x = static_cast<int>(std::min(span.even_first_x, span.odd_first_x));
+    const int end_x = static_cast<int>(std::max(span.even_end_x, span.odd_end_x));
+    const int margin = static_cast<int>(game_object_grid::cell_size);
+
+    object_grid.for_each_in_tiles(
+        SDL_Rect{
+            first_x - margin,
+            static_cast<int>(span.first_y) - margin,
+            end_x - first_x + margin * 2,
+            static_cast<int>(row_count) + margin * 2
+        },
+        [&](game_object* obj) {
+            object_rows[row_index_of(obj->get_tile().y)].push_back(obj);
+        }
+    );
+
+    // Rows hold few objects, sorting them by their position keeps objects on the same row in front of each other:
+    for (auto& entity_row : entity_rows)
+    {
+        if (entity_row.size() < 2) continue;
+
+        std::stable_sort(entity_row.begin(), entity_row.end(), [this](uint32_t a, uint32_t b) {
+            return visible_entity_points[a].y < visible_entity_points[b].y;
+        });
+    }
+
+    for (auto& object_row : object_rows)
+    {
+        if (object_row.size() > 1)
+        {
+            std::stable_sort(object_row.begin(), object_row.end(), [](const game_object* a, const game_object* b) {
+                return a->get_position().y < b->get_position().y;
+            });
+        }
+
+        for (game_object* obj : object_row)
+        {
+            obj->on_sync();
+        }
+    }
+}
+
+void world::draw_object_row(SDL_Renderer* renderer, size_t row_index, double delta_time)
+{
+    if (row_index >= object_rows.size()) return;
+
+    // Entity sprites are tile images, so they're added to the tile batch without drawing anything yet:
+    const float half_tile_width = map->get_tile_width() / 2.0f;
+    const float half_tile_height = map->get_tile_height() / 2.0f;
+
+    for (uint32_t visible_index : entity_rows[row_index])
+    {
+        const tile_image_draw* image_draw = map->get_image_draw(visible_entity_sprites[visible_index]);
+        if (!image_draw) continue;
+
+        const SDL_FPoint& screen_pos = visible_entity_points[visible_index];
+
+        SDL_FRect dest_rect = image_draw->dest_rect;
+        dest_rect.x += screen_pos.x - half_tile_width;
+        dest_rect.y += screen_pos.y - half_tile_height;
+
+        tile_batch.add_quad(image_draw->texture, image_draw->source_rect, image_draw->texture_size, dest_rect);
+    }
+
+    const auto& object_row = object_rows[row_index];
+    if (object_row.empty()) return;
+
+    // Objects draw themselves directly, so the tiles batched so far have to be drawn first:
+    tile_batch.submit(renderer);
+
+    for (game_object* obj : object_row)
+    {
+        obj->on_render(renderer, delta_time);
+    }
+}
+
+bool world::add_cached_chunks(SDL_Renderer* renderer, const visible_tile_span& span, unsigned cached_layer_count)
+{
+    if (span.is_empty()) return true;
+    if (!chunk_cache.begin_frame(renderer, *map)) return false;
+
+    const unsigned chunk_tiles = chunk_cache.get_chunk_tiles();
+    const unsigned chunks_wide = chunk_cache.get_chunks_wide(*map);
+    const unsigned chunks_high = chunk_cache.get_chunks_high(*map);
+
+    // Every chunk holding a visible tile, and the chunks around them as a tile's image can reach into the next chunk.
+    // Chunks don't overlap so the order they're drawn in doesn't matter, those that end up off screen are skipped:
+    const unsigned first_chunk_x = std::max(std::min(span.even_first_x, span.odd_first_x) / chunk_tiles, 1u) - 1;
+    const unsigned last_x = std::max(span.even_end_x, span.odd_end_x) - 1;
+    const unsigned end_chunk_x = std::min(last_x / chunk_tiles + 2, chunks_wide);
+    const unsigned first_chunk_y = std::max(span.first_y / chunk_tiles, 1u) - 1;
+    const unsigned end_chunk_y = std::min((span.end_y - 1) / chunk_tiles + 2, chunks_high);
+
+    const float viewport_left = static_cast<float>(frame.viewport.x);
+    const float viewport_top = static_cast<float>(frame.viewport.y);
+    const float viewport_right = viewport_left + frame.viewport.w;
+    const float viewport_bottom = viewport_top + frame.viewport.h;
+
+    for (unsigned chunk_y = first_chunk_y; chunk_y < end_chunk_y; chunk_y++)
+    {
+        for (unsigned chunk_x = first_chunk_x; chunk_x < end_chunk_x; chunk_x++)
+        {
+            const SDL_FRect chunk_rect = chunk_cache.get_chunk_rect(*map, chunk_x, chunk_y);
+
+            SDL_FPoint chunk_pos = frame.view.tile_to_viewport(SDL_Point{
+                static_cast<int>(chunk_x * chunk_tiles),
+                static_cast<int>(chunk_y * chunk_tiles)
+            });
+
+            const SDL_FRect dest_rect{
+                chunk_pos.x + chunk_rect.x, chunk_pos.y + chunk_rect.y, chunk_rect.w, chunk_rect.h
+            };
+
+            if (dest_rect.x >= viewport_right || dest_rect.x + dest_rect.w <= viewport_left ||
+                dest_rect.y >= viewport_bottom || dest_rect.y + dest_rect.h <= viewport_top)
+            {
+                continue;
+            }
+
+            SDL_Texture* texture = chunk_cache.get_chunk(renderer, *map, chunk_x, chunk_y, cached_layer_count);
+            if (!texture) return false;
+
+            const SDL_Rect source_rect{ 0, 0, static_cast<int>(chunk_rect.w), static_cast<int>(chunk_rect.h) };
+            tile_batch.add_quad(texture, source_rect, SDL_Point{ source_rect.w, source_rect.h }, dest_rect);
+        }
+    }
+
+    return true;
+}
+
+void world::add_selection(const SDL_FPoint& screen_pos)
+{
+    const tile_image_draw* selection_draw = map->get_selection_image_draw();
+    if (!selection_draw) return;
+
+    SDL_FRect dest_rect = selection_draw->dest_rect;
+    dest_rect.x += screen_pos.x;
+    dest_rect.y += screen_pos.y;
+
+    // The selection tile image should be rendered as semi-transparent
+    tile_batch.add_quad(
+        selection_draw->texture,
+        selection_draw->source_rect,
+        selection_draw->texture_size,
+        dest_rect,
+        SDL_Color{ 255, 255, 255, 90 }
+    );
 }
 
 void world::set_selection(const SDL_Point& tile_point)
@@ -221,17 +606,109 @@ unsigned world::get_max_vertical_tiles() const
 
 void isometric::world::add_object(std::shared_ptr<game_object> obj)
 {
-    if (obj)
+    if (obj && !obj->owner)
     {
         obj->setup_transform(get_main_camera(), map);
         objects.push_back(obj);
+
+        // The object's position and velocity are kept with the rest of the entities from now on, it draws itself so
+        // its entity has no sprite:
+        obj->entity_handle = entities.create(obj->position, empty_tile_image, 0);
+        const uint32_t index = entities.get_index(obj->entity_handle);
+        entities.set_velocity(index, obj->velocity);
+        entities.set_object(index, obj.get());
+
+        obj->owner = this;
+        object_grid.insert(obj.get(), transform.world_pixels_to_world_tile(obj->position));
     }
 }
 
 void isometric::world::remove_object(std::shared_ptr<game_object> obj)
 {
-    if (obj)
+    if (obj && obj->owner == this)
     {
+        // The object keeps its position once the entity holding it is gone:
+        obj->position = obj->get_position();
+        entities.destroy(obj->entity_handle);
+        obj->entity_handle = entity();
+
+        object_grid.remove(obj.get());
+        obj->owner = nullptr;
+
         objects.remove(obj);
+
+        // The last synced frame may still draw the object, so it's kept alive until the next sync():
+        removed_objects.push_back(obj);
     }
 }
+
+void isometric::world::object_moved(game_object* obj, const SDL_FPoint& position)
+{
+    entities.set_position(entities.get_index(obj->entity_handle), position);
+    object_grid.move(obj, transform.world_pixels_to_world_tile(position));
+}
+
+SDL_Rect isometric::world::world_rect_to_tile_rect(const SDL_FRect& world_rect) const
+{
+    // Tiles on rows above and below overlap each other by half a tile, so pad the tiles found at the corners by one:
+    SDL_Point top_left = transform.world_pixels_to_world_tile(SDL_FPoint{ world_rect.x, world_rect.y });
+    SDL_Point bottom_right = transform.world_pixels_to_world_tile(
+        SDL_FPoint{ world_rect.x + world_rect.w, world_rect.y + world_rect.h }
+    );
+
+    return SDL_Rect{
+        top_left.x - 1,
+        top_left.y - 1,
+        bottom_right.x - top_left.x + 3,
+        bottom_right.y - top_left.y + 3
+    };
+}
+
+void isometric::world::query_objects(const SDL_FRect& world_rect, std::vector<game_object*>& results) const
+{
+    object_grid.for_each_in_tiles(world_rect_to_tile_rect(world_rect), [&](game_object* obj) {
+        const SDL_FPoint position = obj->get_position();
+
+        if (position.x >= world_rect.x && position.x < world_rect.x + world_rect.w &&
+            position.y >= world_rect.y && position.y < world_rect.y + world_rect.h)
+        {
+            results.push_back(obj);
+        }
+    });
+}
+
+void isometric::world::query_objects(const SDL_FPoint& centre, float radius, std::vector<game_object*>& results) const
+{
+    const SDL_FRect bounds{ centre.x - radius, centre.y - radius, radius * 2.0f, radius * 2.0f };
+
+    object_grid.for_each_in_tiles(world_rect_to_tile_rect(bounds), [&](game_object* obj) {
+        const float dx = obj->get_position().x - centre.x;
+        const float dy = obj->get_position().y - centre.y;
+
+        if (dx * dx + dy * dy <= radius * radius)
+        {
+            results.push_back(obj);
+        }
+    });
+}
+
+void isometric::world::query_objects_diamond(
+    const SDL_FPoint& centre,
+    float half_width, float half_height,
+    std::vector<game_object*>& results
+) const
+{
+    if (half_width <= 0.0f || half_height <= 0.0f) return;
+
+    const SDL_FRect bounds{ centre.x - half_width, centre.y - half_height, half_width * 2.0f, half_height * 2.0f };
+
+    object_grid.for_each_in_tiles(world_rect_to_tile_rect(bounds), [&](game_object* obj) {
+        const float dx = std::abs(obj->get_position().x - centre.x) / half_width;
+        const float dy = std::abs(obj->get_position().y - centre.y) / half_height;
+
+        if (dx + dy <= 1.0f)
+        {
+            results.push_back(obj);
+        }
+    });
+}
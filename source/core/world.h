@@ -7,6 +7,9 @@
 #include "camera.h"
 #include "tile_map.h"
 #include "game_object.h"
+#include "entity_store.h"
+#include "tile_chunk_cache.h"
+#include "../rendering/geometry_batch.h"
 
 namespace isometric {
 
@@ -15,17 +18,86 @@ namespace isometric {
     private:
         std::vector<std::shared_ptr<camera>> cameras;
         std::list<std::shared_ptr<game_object>> objects;
+        std::vector<std::shared_ptr<game_object>> removed_objects;  // Kept alive until the next sync()
+        game_object_grid object_grid;                   // Where every object is, for culling and region queries
+        entity_store entities;                          // Sprites and the position and velocity of every object
         std::shared_ptr<tile_map> map;
         transform transform;
+        view_transform view;                            // Snapshot of transform, taken in update()
         SDL_Point selected_world_tile;
+        std::vector<const tile_image_index*> layer_runs; // Used by render() to scan each layer a chunk at a time
+        std::vector<SDL_Point> row_tile_points;         // The tiles of the row being drawn, reused every row
+        std::vector<SDL_FPoint> row_screen_points;      // Viewport position of each of row_tile_points
+        rendering::geometry_batch tile_batch;           // Every visible tile is drawn through this in one submit
+
+        // Tile images that reach outside of their tile, which are drawn in between the rows of objects:
+        struct raised_tile
+        {
+            const tile_image_draw* image_draw = nullptr;
+            SDL_FRect dest_rect = { 0 };
+            Uint8 opacity = 255;
+        };
+
+        std::vector<raised_tile> raised_tiles;          // Reused every frame
+        std::vector<size_t> raised_row_ends;            // Per visible row, the end of its tiles in raised_tiles
+        tile_chunk_cache chunk_cache;                   // Pre-rendered static layers
+
+        bool add_cached_chunks(SDL_Renderer* renderer, const visible_tile_span& span, unsigned cached_layer_count);
+        void add_selection(const SDL_FPoint& screen_pos);
+        void add_row_tiles(const visible_tile_span::row& row, unsigned cached_layer_count);
+
+        std::vector<std::vector<game_object*>> object_rows; // Visible objects by tile row, reused every frame
+        std::vector<std::vector<uint32_t>> entity_rows;     // Visible entities by tile row, reused every frame
+        std::vector<uint32_t> visible_entities;             // Dense indices of the entities that can be seen
+        std::vector<SDL_FPoint> visible_entity_points;      // Viewport position of each visible entity
+        std::vector<tile_image_index> visible_entity_sprites;
+
+        /// <summary>
+        /// Everything render_frame() needs that update() changes, copied by sync()
+        /// </summary>
+        struct frame_state
+        {
+            view_transform view;
+            visible_tile_span span;
+            SDL_Rect viewport = { 0 };
+            SDL_Point selection = { 0 };
+            bool has_selection = false;
+            bool has_camera = false;
+        };
+
+        frame_state frame;
+        void collect_visible_objects(const visible_tile_span& span);
+        void draw_object_row(SDL_Renderer* renderer, size_t row_index, double delta_time);
+
+        friend class game_object;
+        void object_moved(game_object* obj, const SDL_FPoint& position);
+        SDL_Rect world_rect_to_tile_rect(const SDL_FRect& world_rect) const;
 
         bool update_called = false;
 
     public:
         world(std::shared_ptr<tile_map> map, std::shared_ptr<camera> main_camera);
+        ~world();
         std::shared_ptr<camera> get_main_camera() const;
 
         void update(double delta_time);
+
+        /// <summary>
+        /// Copy the state of the world that rendering needs (what can be seen, where from and the selection) for the
+        /// next render_frame(). Call while nothing is updating or rendering the world.
+        /// </summary>
+        void sync();
+
+        /// <summary>
+        /// Draw the world as it was when sync() was last called. The world's own state isn't touched so this can run
+        /// while update() works on the next frame, but the tile map is drawn as it is: edit it between frames (such
+        /// as from on_sync) when updating and rendering overlap.
+        /// </summary>
+        void render_frame(SDL_Renderer* renderer, double delta_time);
+
+        /// <summary>
+        /// Equivalent to sync() and then render_frame(), for when updating and rendering take turns
+        /// </summary>
         void render(SDL_Renderer* renderer, double delta_time);
 
         void set_selection(const SDL_Point& tile_point);
@@ -41,8 +113,48 @@ namespace isometric {
             return this->transform;
         }
 
+        /// <returns>The view of the world as of the last sync(), what render_frame() draws with</returns>
+        const view_transform& get_frame_view() const { return frame.view; }
+
+        /// <summary>
+        /// The entities of the world. Entities with a sprite and the entity_visible flag are drawn sorted in with
+        /// the tiles, every entity with a velocity is moved in update().
+        /// </summary>
+        entity_store& get_entities() { return entities; }
+        const entity_store& get_entities() const { return entities; }
+
         void add_object(std::shared_ptr<game_object> obj);
         void remove_object(std::shared_ptr<game_object> obj);
+        size_t get_object_count() const { return object_grid.get_object_count(); }
+
+        /// <summary>
+        /// Find the objects with a position inside a rect
+        /// </summary>
+        /// <param name="world_rect">The area to search, in world pixels</param>
+        /// <param name="results">Objects that are found are added to this</param>
+        void query_objects(const SDL_FRect& world_rect, std::vector<game_object*>& results) const;
+
+        /// <summary>
+        /// Find the objects with a position within a distance of a point
+        /// </summary>
+        /// <param name="centre">The centre of the area to search, in world pixels</param>
+        /// <param name="radius">The distance from centre to search, in pixels</param>
+        /// <param name="results">Objects that are found are added to this</param>
+        void query_objects(const SDL_FPoint& centre, float radius, std::vector<game_object*>& results) const;
+
+        /// <summary>
+        /// Find the objects with a position inside a diamond, such as the area covered by a number of tiles around
+        /// a tile (a diamond half_width tiles wide is half_width * tile width pixels wide)
+        /// </summary>
+        /// <param name="centre">The centre of the diamond, in world pixels</param>
+        /// <param name="half_width">The distance from the centre to the left and right corners, in pixels</param>
+        /// <param name="half_height">The distance from the centre to the top and bottom corners, in pixels</param>
+        /// <param name="results">Objects that are found are added to this</param>
+        void query_objects_diamond(
+            const SDL_FPoint& centre,
+            float half_width, float half_height,
+            std::vector<game_object*>& results
+        ) const;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace isometric {
+
+    enum class render_mode {
+        window,     // Draw to a window with a hardware accelerated renderer if there is one
+        offscreen,  // Draw to an in-memory surface with SDL's software renderer, no display or GPU needed
+        none        // Update without drawing, assets are still loaded with the software renderer
+    };
+
+}
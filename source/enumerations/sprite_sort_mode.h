@@ -0,0 +1,10 @@
+#pragma once
+
+namespace isometric {
+
+    enum class sprite_sort_mode {
+        depth,      // Back to front by depth, sprites at the same depth are grouped by texture
+        texture     // Grouped by texture only, for sprites that never overlap
+    };
+
+}
@@ -42,6 +42,11 @@ void fps_display_module::on_update(double delta_time)
 }
 
 void fps_display_module::on_late_update(double delta_time)
+{
+
+}
+
+void fps_display_module::on_render(double delta_time)
 {
     static double last_delta_time = delta_time;
     SDL_Rect viewport = application::get_app()->get_viewport();
@@ -50,6 +55,7 @@ void fps_display_module::on_late_update(double delta_time)
     if (!graphics) return;
 
     static double current_framerate = framerate.get();
+    static render_counters current_counters = application::get_app()->get_render_counters();
     static double elapsed_since_last_update = 0.0;
     elapsed_since_last_update += delta_time;
 
@@ -57,6 +63,7 @@ void fps_display_module::on_late_update(double delta_time)
     {
         elapsed_since_last_update = 0.0;
         current_framerate = framerate.get();
+        current_counters = application::get_app()->get_render_counters();
         last_delta_time = delta_time;
     }
 
@@ -68,11 +75,35 @@ void fps_display_module::on_late_update(double delta_time)
 
     // Render using bitmap font:
     bitmap_font->set_color(0xFFFFFFFF);
-    bitmap_font->draw(
-        std::format("FPS: {:.1f} | DELTA: {:.2f}ms", current_framerate, last_delta_time * 1000.0),
-        viewport,
-        position
+    const std::string fps_text = std::format(
+        "FPS: {:.1f} | DELTA: {:.2f}ms", current_framerate, last_delta_time * 1000.0
     );
+    bitmap_font->draw(fps_text, viewport, position);
+
+    // The render counters go on the line below (or above, when the overlay is at the bottom):
+    const std::string counters_text = std::format(
+        "DRAWS: {} | TEX: {} | VERTS: {} | OVERDRAW: {:.2f}x",
+        current_counters.draw_calls,
+        current_counters.texture_switches,
+        current_counters.vertices,
+        current_counters.get_overdraw()
+    );
+
+    const int line_height = bitmap_font->measure(fps_text).h;
+    switch (position)
+    {
+    case content_align::bottom_left:
+    case content_align::bottom_center:
+    case content_align::bottom_right:
+        viewport.h -= line_height;
+        break;
+    default:
+        viewport.y += line_height;
+        viewport.h -= line_height;
+        break;
+    }
+
+    bitmap_font->draw(counters_text, viewport, position);
 
     // Render using what graphics uses (SDL_ttf):
     /*
@@ -18,6 +18,7 @@ namespace isometric::game {
         void on_update(double delta_time) override;
         void on_late_update(double delta_time) override;
         void on_fixed_update(double fixed_delta_time) override;
+        void on_render(double delta_time) override;
 
         double get_update_interval() const;
         void set_update_interval(double interval);
@@ -39,6 +39,11 @@ bool game_application::on_start()
     this->fps_display_module = module::create<isometric::game::fps_display_module>(true);
     register_module(this->fps_display_module);
 
+    // None of the modules update the same state, so their updates can all run at once:
+    this->camera_module->declare_access({ "input", "map" }, { "camera" });
+    this->player_module->declare_access({ "input" }, { "entities" });
+    this->fps_display_module->declare_access({});
+
     return application::on_start();
 }
 
@@ -49,13 +54,32 @@ bool isometric::game::game_application::load_map()
 
     grasslands_image = image::load("grasslands", "content/grassland_tiles.png");
 
-    map = isometric::tile_map::create(
-        1024,           // entire map width in tiles
-        1024,           // entire map height in tiles
-        tile_width,
-        tile_height
-    );
+    // Only a map file that was asked for is used, so changes to the code below are never hidden by an old file. It's
+    // memory mapped, so loading it is quick no matter how large the map is:
+    if (!map_path.empty())
+    {
+        map = isometric::tile_map::load(map_path);
+        if (!map)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load the map file '%s'", map_path.c_str());
+            return false;
+        }
+    }
 
+    bool build_map = map == nullptr;
+
+    if (build_map)
+    {
+        map = isometric::tile_map::create(
+            1024,           // entire map width in tiles
+            1024,           // entire map height in tiles
+            tile_width,
+            tile_height,
+            isometric::tile_map_storage::chunked
+        );
+    }
+
+    // Images aren't stored in map files, so they're always added here:
     map->add_image(
         isometric::tile_image::create(
             "selection", 0,
@@ -66,11 +90,8 @@ bool isometric::game::game_application::load_map()
     );
     map->set_selection_image(0);
 
-    map->add_layer("grass");
-    unsigned grass_source_x = 0;
     for (unsigned i = 1, grass_source_x = 0; i < 16; i++, grass_source_x += 64)
     {
-
         auto grass_tile_image = isometric::tile_image::create(
             "grass" + std::to_string(i), i,
             grasslands_image->get_texture(),
@@ -79,10 +100,8 @@ bool isometric::game::game_application::load_map()
         );
 
         map->add_image(grass_tile_image);
-        map->add_layer_default_image("grass", i);
     }
 
-    unsigned foliage_layer_id = map->add_layer("foliage");
     auto bush1_tile_image = isometric::tile_image::create(
         "bush1", 99,
         grasslands_image->get_texture(),
@@ -92,22 +111,62 @@ bool isometric::game::game_application::load_map()
 
     map->add_image(bush1_tile_image);
 
-    map->set_tile(0, 0, isometric::tile())->set_image_id(foliage_layer_id, 99);
-    map->set_tile(9, 9, isometric::tile())->set_image_id(foliage_layer_id, 99);
+    // The player is a plain white square for now, taken from the middle of the selection image:
+    map->add_image(
+        isometric::tile_image::create(
+            "player", isometric::game::player_module::player_image_id,
+            grasslands_image->get_texture(),
+            984, 168,
+            16, 16
+        )
+    );
+
+    if (build_map)
+    {
+        map->set_seed(0x15043E7Fu);
+        unsigned grass_layer_id = map->add_layer("grass");
+        map->set_layer_static(grass_layer_id);
+        for (unsigned i = 1; i < 16; i++)
+        {
+            map->add_layer_default_image(grass_layer_id, i);
+        }
+
+        unsigned foliage_layer_id = map->add_layer("foliage");
+        map->set_tile(0, 0).set_image_id(foliage_layer_id, 99);
+        map->set_tile(9, 9).set_image_id(foliage_layer_id, 99);
+
+        if (!save_map_path.empty() && !map->save(save_map_path))
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to save the map to '%s'", save_map_path.c_str());
+        }
+    }
 
     return true;
 }
 
 void isometric::game::game_application::on_update(double delta_time)
 {
-    auto renderer = application::get_app()->get_graphics()->get_renderer();
-
     world->update(delta_time);
-    world->render(renderer, delta_time);
 
     return application::on_update(delta_time);
 }
 
+void isometric::game::game_application::on_sync()
+{
+    world->sync();
+
+    return application::on_sync();
+}
+
+void isometric::game::game_application::on_render(double delta_time)
+{
+    auto renderer = application::get_app()->get_graphics()->get_renderer();
+
+    world->render_frame(renderer, delta_time);
+
+    return application::on_render(delta_time);
+}
+
 void isometric::game::game_application::on_fixed_update(double fixed_delta_time)
 {
 
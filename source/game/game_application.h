@@ -19,12 +19,29 @@ namespace isometric::game {
         std::shared_ptr<player_module> player_module;
         std::shared_ptr<fps_display_module> fps_display_module;
 
+        std::string map_path;           // A saved map to load instead of building the map, if not empty
+        std::string save_map_path;      // Where to save the built map, if not empty
+
         bool load_map();
 
+    public:
+        /// <summary>
+        /// Load the map from a map file saved with set_save_map_path instead of building it. The file isn't checked
+        /// against the code that builds the map, so save it again after changing that code.
+        /// </summary>
+        void set_map_path(const std::string& path) { map_path = path; }
+
+        /// <summary>
+        /// Save the map to a map file once it has been built
+        /// </summary>
+        void set_save_map_path(const std::string& path) { save_map_path = path; }
+
     protected:
         bool on_start() override;
         void on_update(double delta_time) override;
         void on_fixed_update(double fixed_delta_time) override;
+        void on_sync() override;
+        void on_render(double delta_time) override;
     };
 
 }
\ No newline at end of file
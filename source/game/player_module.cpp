@@ -11,18 +11,26 @@ void player_module::on_registered()
 
 void player_module::on_unregister()
 {
-
+    if (world) world->get_entities().destroy(player_entity);
 }
 
 void player_module::setup(std::shared_ptr<tile_map> map, std::shared_ptr<isometric::world> world)
 {
     this->map = map;
     this->world = world;
+
+    // The player is an entity so the world draws it in the same batch as the tiles, sorted by its y position:
+    player_entity = world->get_entities().create(location, static_cast<tile_image_index>(player_image_id));
 }
 
 void player_module::set_player_location(const SDL_FPoint& point)
 {
     location = point;
+    if (!world) return;
+
+    auto& entities = world->get_entities();
+    const uint32_t index = entities.get_index(player_entity);
+    if (index != entity_store::no_index) entities.set_position(index, location);
 }
 
 const SDL_FPoint& player_module::get_player_location() const
@@ -50,34 +58,13 @@ void player_module::on_update(double delta_time)
     {
         location.y += static_cast<float>(speed * delta_time);
     }
+
+    set_player_location(location);
 }
 
 void player_module::on_late_update(double delta_time)
 {
-    auto graphics = application::get_app()->get_graphics();
-    auto renderer = graphics->get_renderer();
-    auto main_camera = world->get_main_camera();
-    const auto& transform = world->get_transform();
-
-    if (!graphics || !renderer || !main_camera) return;
-
-    constexpr float player_size = 16;
-
-    SDL_FPoint player_in_world{
-        location.x,
-        location.y
-    };
-
-    auto player_in_viewport = transform.world_pixels_to_viewport_pixels(player_in_world);
-
-    SDL_FRect player_rect{
-        player_in_viewport.x,
-        player_in_viewport.y,
-        player_size, player_size
-    };
 
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-    SDL_RenderFillRectF(renderer, &player_rect);
 }
 
 void player_module::on_fixed_update(double fixed_delta_time)
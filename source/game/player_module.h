@@ -9,6 +9,7 @@ namespace isometric::game {
         std::shared_ptr<tile_map> map = nullptr;
         std::shared_ptr<world> world = nullptr;
         SDL_FPoint location = { 0.0f, 0.0f };
+        entity player_entity;   // Draws the player sorted in with the rest of the world
 
     protected:
         void on_registered() override;
@@ -19,6 +20,8 @@ namespace isometric::game {
         void on_fixed_update(double fixed_delta_time) override;
 
     public:
+        static constexpr unsigned player_image_id = 100;   // The tile map image the player is drawn with
+
         void setup(std::shared_ptr<tile_map> map, std::shared_ptr<isometric::world> world);
         void set_player_location(const SDL_FPoint& point);
         const SDL_FPoint& get_player_location() const;
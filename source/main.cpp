@@ -1,11 +1,37 @@
 #include <memory>
+#include <string>
 #include "./game/game_application.h"
 
 using namespace isometric;
 using namespace isometric::game;
 
+namespace {
+
+    void print_usage()
+    {
+        SDL_Log("Usage: IsometricLab [--map saved.map] [--save-map saved.map]");
+    }
+}
+
 int main(int argc, char* argv[])
 {
+    std::string map_path;
+    std::string save_map_path;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (argument == "--map" && has_value) map_path = argv[++i];
+        else if (argument == "--save-map" && has_value) save_map_path = argv[++i];
+        else
+        {
+            print_usage();
+            return -1;
+        }
+    }
+
     try
     {
         application_setup setup;
@@ -17,6 +43,8 @@ int main(int argc, char* argv[])
         setup.broadcast_fps = true;
 
         auto app = application::create<game_application>(setup);
+        app->set_map_path(map_path);
+        app->set_save_map_path(save_map_path);
 
         app->start();
     }
@@ -0,0 +1,124 @@
+#include "geometry_batch.h"
+#include "render_layer.h"
+
+using namespace isometric::rendering;
+
+void geometry_batch::clear()
+{
+#if ISOMETRIC_HAS_RENDER_GEOMETRY
+    vertices.clear();
+    indices.clear();
+    segments.clear();
+#else
+    quads.clear();
+#endif
+
+    quad_count = 0;
+}
+
+void geometry_batch::add_quad(
+    SDL_Texture* texture,
+    const SDL_Rect& source_rect,
+    const SDL_Point& texture_size,
+    const SDL_FRect& dest_rect,
+    const SDL_Color& color
+)
+{
+    quad_count++;
+
+#if ISOMETRIC_HAS_RENDER_GEOMETRY
+    const float texture_w = texture_size.x > 0 ? static_cast<float>(texture_size.x) : 1.0f;
+    const float texture_h = texture_size.y > 0 ? static_cast<float>(texture_size.y) : 1.0f;
+
+    const float u0 = source_rect.x / texture_w;
+    const float v0 = source_rect.y / texture_h;
+    const float u1 = (source_rect.x + source_rect.w) / texture_w;
+    const float v1 = (source_rect.y + source_rect.h) / texture_h;
+
+    const float x0 = dest_rect.x;
+    const float y0 = dest_rect.y;
+    const float x1 = dest_rect.x + dest_rect.w;
+    const float y1 = dest_rect.y + dest_rect.h;
+
+    // Continue the current segment if it uses the same texture, otherwise start a new one so draw order is kept:
+    if (segments.empty() || segments.back().texture != texture)
+    {
+        segments.push_back(segment{ texture, indices.size(), 0 });
+    }
+
+    const int first_vertex = static_cast<int>(vertices.size());
+
+    vertices.push_back(SDL_Vertex{ SDL_FPoint{ x0, y0 }, color, SDL_FPoint{ u0, v0 } });   // Top left
+    vertices.push_back(SDL_Vertex{ SDL_FPoint{ x1, y0 }, color, SDL_FPoint{ u1, v0 } });   // Top right
+    vertices.push_back(SDL_Vertex{ SDL_FPoint{ x1, y1 }, color, SDL_FPoint{ u1, v1 } });   // Bottom right
+    vertices.push_back(SDL_Vertex{ SDL_FPoint{ x0, y1 }, color, SDL_FPoint{ u0, v1 } });   // Bottom left
+
+    const int quad_indices[] = { 0, 1, 2, 0, 2, 3 };
+    for (int index : quad_indices)
+    {
+        indices.push_back(first_vertex + index);
+    }
+
+    segments.back().index_count += 6;
+#else
+    quads.push_back(quad{ texture, source_rect, dest_rect, color });
+#endif
+}
+
+size_t geometry_batch::submit(SDL_Renderer* renderer)
+{
+    size_t draw_calls = 0;
+
+#if ISOMETRIC_HAS_RENDER_GEOMETRY
+    for (const auto& batch_segment : segments)
+    {
+        render_layer::draw_geometry(
+            renderer,
+            batch_segment.texture,
+            vertices.data(), static_cast<int>(vertices.size()),
+            indices.data() + batch_segment.first_index, static_cast<int>(batch_segment.index_count)
+        );
+
+        draw_calls++;
+    }
+#else
+    for (const auto& batch_quad : quads)
+    {
+        if (!batch_quad.texture)
+        {
+            // Vertex colors blend with what's below, so the fill has to as well:
+            render_layer::set_draw_blend_mode(renderer, SDL_BLENDMODE_BLEND);
+            render_layer::set_draw_color(
+                renderer, batch_quad.color.r, batch_quad.color.g, batch_quad.color.b, batch_quad.color.a
+            );
+            render_layer::fill_rect(renderer, &batch_quad.dest_rect);
+
+            draw_calls++;
+            continue;
+        }
+
+        // Most quads are white and opaque, those are drawn without touching the texture's mods at all:
+        const SDL_Color& color = batch_quad.color;
+        const bool modulated = color.r != 255 || color.g != 255 || color.b != 255 || color.a != 255;
+
+        if (modulated)
+        {
+            render_layer::set_color_mod(batch_quad.texture, color.r, color.g, color.b);
+            render_layer::set_alpha_mod(batch_quad.texture, color.a);
+        }
+
+        render_layer::copy(renderer, batch_quad.texture, &batch_quad.source_rect, &batch_quad.dest_rect);
+
+        if (modulated)
+        {
+            render_layer::set_color_mod(batch_quad.texture, 255, 255, 255);
+            render_layer::set_alpha_mod(batch_quad.texture, 255);
+        }
+
+        draw_calls++;
+    }
+#endif
+
+    clear();
+    return draw_calls;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+
+// SDL_RenderGeometry was added in SDL 2.0.18, which the project requires. The fallback for older headers only
+// keeps the batch working if SDL is downgraded, it draws one SDL_RenderCopyF per quad:
+#define ISOMETRIC_HAS_RENDER_GEOMETRY SDL_VERSION_ATLEAST(2, 0, 18)
+
+namespace isometric::rendering {
+
+    /// <summary>
+    /// Collects textured quads and submits them with as few draw calls as possible. Quads are kept in the order they
+    /// are added and consecutive quads that use the same texture (such as tiles from one atlas) become a single
+    /// SDL_RenderGeometry call, so a whole screen of tiles is one call instead of one SDL_RenderCopyF per tile.
+    ///
+    /// The vertex and index arrays are kept between frames, so once a batch has grown to the size of a frame adding
+    /// quads no longer allocates.
+    /// </summary>
+    class geometry_batch
+    {
+    private:
+        struct segment
+        {
+            SDL_Texture* texture = nullptr;
+            size_t first_index = 0;
+            size_t index_count = 0;
+        };
+
+#if ISOMETRIC_HAS_RENDER_GEOMETRY
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+        std::vector<segment> segments;
+#else
+        struct quad
+        {
+            SDL_Texture* texture = nullptr;
+            SDL_Rect source_rect = { 0 };
+            SDL_FRect dest_rect = { 0 };
+            SDL_Color color = { 0 };
+        };
+
+        std::vector<quad> quads;
+#endif
+
+        size_t quad_count = 0;
+
+    public:
+        /// <summary>
+        /// Remove every quad from the batch, without releasing its memory
+        /// </summary>
+        void clear();
+
+        /// <summary>
+        /// Add a textured quad to the batch
+        /// </summary>
+        /// <param name="texture">The texture to draw from, or nullptr to fill the quad with color</param>
+        /// <param name="source_rect">Where the image is in the texture, in pixels</param>
+        /// <param name="texture_size">The size of the texture in pixels, used to find texture coordinates</param>
+        /// <param name="dest_rect">Where to draw the quad</param>
+        /// <param name="color">Multiplied with the texture, use an alpha below 255 for transparency</param>
+        void add_quad(
+            SDL_Texture* texture,
+            const SDL_Rect& source_rect,
+            const SDL_Point& texture_size,
+            const SDL_FRect& dest_rect,
+            const SDL_Color& color = SDL_Color{ 255, 255, 255, 255 }
+        );
+
+        size_t get_quad_count() const { return quad_count; }
+
+        /// <summary>
+        /// Draw every quad in the batch, in the order they were added, and then clear it
+        /// </summary>
+        /// <returns>The number of draw calls that were made</returns>
+        size_t submit(SDL_Renderer* renderer);
+    };
+
+}
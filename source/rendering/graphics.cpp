@@ -1,10 +1,12 @@
 #include "graphics.h"
 #include "../application/application.h"
+#include "../tools/profiler.h"
+#include "render_layer.h"
 #include <algorithm>
 
 using namespace isometric::rendering;
 
-graphics::graphics(SDL_Renderer* renderer) : renderer(renderer)
+graphics::graphics(SDL_Renderer* renderer) : renderer(renderer), texts(renderer)
 {
     pixel_format = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA8888);
     asset_manager = application::get_app()->get_asset_manager();
@@ -31,28 +33,22 @@ void graphics::present() const
 {
     if (!has_sanity()) return;
 
-    SDL_RenderPresent(renderer);
+    tools::profile_zone zone("graphics::present");
+    render_layer::present(renderer);
 }
 
 void graphics::set_color(uint32_t color)
 {
     if (!has_sanity()) return;
 
-    SDL_Color draw_color{};
-    SDL_GetRGBA(
-        color, pixel_format,
-        &draw_color.r,
-        &draw_color.g,
-        &draw_color.b,
-        &draw_color.a
-    );
-
-    SDL_SetRenderDrawColor(
+    // Colors are RGBA8888, the same layout get_color returns. The render layer skips the call if the color is
+    // already set, so setting the same color every frame costs nothing:
+    render_layer::set_draw_color(
         renderer,
-        draw_color.r,
-        draw_color.g,
-        draw_color.b,
-        draw_color.a
+        static_cast<Uint8>(color >> 24),
+        static_cast<Uint8>(color >> 16),
+        static_cast<Uint8>(color >> 8),
+        static_cast<Uint8>(color)
     );
 }
 
@@ -71,22 +67,14 @@ SDL_Color graphics::get_sdl_color() const
 {
     if (!has_sanity()) return { 0 };
 
-    SDL_Color draw_color{};
-    SDL_GetRenderDrawColor(renderer,
-        &draw_color.r,
-        &draw_color.g,
-        &draw_color.b,
-        &draw_color.a
-    );
-
-    return draw_color;
+    return render_layer::get_draw_color(renderer);
 }
 
 void graphics::clear()
 {
     if (!has_sanity()) return;
 
-    SDL_RenderClear(renderer);
+    render_layer::clear(renderer);
 }
 
 void graphics::clear(uint32_t color)
@@ -95,7 +83,7 @@ void graphics::clear(uint32_t color)
 
     set_color(color);
 
-    SDL_RenderClear(renderer);
+    render_layer::clear(renderer);
 }
 
 SDL_FRect graphics::size_text(
@@ -104,10 +92,8 @@ SDL_FRect graphics::size_text(
     const SDL_FPoint& point
 )
 {
-    auto& asset = (*this->asset_manager)[font_name];
-    if (!asset) return { 0 };
-
-    auto font = dynamic_cast<const isometric::assets::font*>(asset.get());
+    auto font = find_font(font_name);
+    if (!font) return { 0 };
 
     int width = 0, height = 0;
     TTF_SizeUTF8(font->get_font(), text.c_str(), &width, &height);
@@ -115,6 +101,24 @@ SDL_FRect graphics::size_text(
     return SDL_FRect{ point.x, point.y, static_cast<float>(width), static_cast<float>(height) };
 }
 
+const isometric::assets::font* graphics::find_font(const std::string& font_name)
+{
+    auto& asset = (*this->asset_manager)[font_name];
+    if (!asset) return nullptr;
+
+    return dynamic_cast<const isometric::assets::font*>(asset.get());
+}
+
+void graphics::draw_cached_text(const text_cache::cached_text& text, const SDL_Rect& destination)
+{
+    // Cached text is white, so the draw color is applied with the texture mods:
+    SDL_Color sdl_color = get_sdl_color();
+    render_layer::set_color_mod(text.texture, sdl_color.r, sdl_color.g, sdl_color.b);
+    render_layer::set_alpha_mod(text.texture, sdl_color.a);
+
+    render_layer::copy(renderer, text.texture, &text.source_rect, &destination);
+}
+
 void graphics::draw_text(
     const std::string& font_name, int point_size,
     const std::string& text,
@@ -122,26 +126,36 @@ void graphics::draw_text(
     content_align align
 )
 {
-    auto& asset = (*this->asset_manager)[font_name];
-    if (!asset) return;
-
-    auto font = dynamic_cast<const isometric::assets::font*>(asset.get());
-
-    SDL_Texture* texture = nullptr;
-    SDL_Surface* font_surface = nullptr;
+    auto font = find_font(font_name);
+    if (font) draw_text(*font, point_size, text, point, align);
+}
 
-    font_surface = TTF_RenderUTF8_Blended(font->get_font(point_size), text.c_str(), get_sdl_color());
+void graphics::draw_text(
+    const std::string& font_name, int point_size,
+    const std::string& text,
+    const SDL_Rect& destination,
+    content_align align,
+    bool wrap
+)
+{
+    auto font = find_font(font_name);
+    if (font) draw_text(*font, point_size, text, destination, align, wrap);
+}
 
-    int text_width = font_surface->w;
-    int text_height = font_surface->h;
+void graphics::draw_text(
+    const isometric::assets::font& font, int point_size,
+    const std::string& text,
+    const SDL_Point& point,
+    content_align align
+)
+{
+    if (!has_sanity()) return;
 
-    if (font_surface)
-    {
-        texture = SDL_CreateTextureFromSurface(renderer, font_surface);
-        SDL_FreeSurface(font_surface);
-    }
+    const text_cache::cached_text* cached = texts.get(font.get_font(point_size), point_size, text);
+    if (!cached) return;
 
-    if (!texture) return;
+    int text_width = cached->source_rect.w;
+    int text_height = cached->source_rect.h;
 
     SDL_Rect dest = SDL_Rect{ point.x, point.y, text_width, text_height };
 
@@ -175,45 +189,26 @@ void graphics::draw_text(
         break;
     }
 
-    SDL_RenderCopy(renderer, texture, NULL, &dest);
-    SDL_DestroyTexture(texture);
+    draw_cached_text(*cached, dest);
 }
 
 void graphics::draw_text(
-    const std::string& font_name, int point_size,
+    const isometric::assets::font& font, int point_size,
     const std::string& text,
     const SDL_Rect& destination,
     content_align align,
     bool wrap
 )
 {
-    auto& asset = (*this->asset_manager)[font_name];
-    if (!asset) return;
-
-    auto font = dynamic_cast<const isometric::assets::font*>(asset.get());
-
-    SDL_Texture* texture = nullptr;
-    SDL_Surface* font_surface = nullptr;
-
-    if (wrap)
-    {
-        font_surface = TTF_RenderUTF8_Blended_Wrapped(font->get_font(point_size), text.c_str(), SDL_Color{ 255, 255, 255, 255 }, destination.w);
-    }
-    else
-    {
-        font_surface = TTF_RenderUTF8_Blended(font->get_font(point_size), text.c_str(), SDL_Color{ 255, 255, 255, 255 });
-    }
-
-    int text_width = font_surface->w;
-    int text_height = font_surface->h;
+    if (!has_sanity()) return;
 
-    if (font_surface)
-    {
-        texture = SDL_CreateTextureFromSurface(renderer, font_surface);
-        SDL_FreeSurface(font_surface);
-    }
+    const text_cache::cached_text* cached = texts.get(
+        font.get_font(point_size), point_size, text, wrap ? destination.w : -1
+    );
+    if (!cached) return;
 
-    if (!texture) return;
+    int text_width = cached->source_rect.w;
+    int text_height = cached->source_rect.h;
 
     SDL_Rect real_dest = SDL_Rect{ destination.x, destination.y, text_width, text_height };
 
@@ -247,10 +242,5 @@ void graphics::draw_text(
         break;
     }
 
-    SDL_Color sdl_color = get_sdl_color();
-    SDL_SetTextureColorMod(texture, sdl_color.r, sdl_color.g, sdl_color.b);
-    SDL_SetTextureAlphaMod(texture, sdl_color.a);
-
-    SDL_RenderCopy(renderer, texture, NULL, &real_dest);
-    SDL_DestroyTexture(texture);
+    draw_cached_text(*cached, real_dest);
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <SDL_ttf.h>
 #include "../assets/asset_management.h"
 #include "../enumerations/content_align.h"
+#include "text_cache.h"
 
 namespace isometric::rendering {
 
@@ -16,15 +17,25 @@ namespace isometric::rendering {
         SDL_Renderer* renderer = nullptr;
         SDL_PixelFormat* pixel_format = nullptr;
         std::shared_ptr<isometric::assets::asset_management> asset_manager = nullptr;
+        text_cache texts;
 
         graphics(SDL_Renderer* renderer);
         void present() const;
         bool has_sanity() const;
 
+        const isometric::assets::font* find_font(const std::string& font_name);
+        void draw_cached_text(const text_cache::cached_text& text, const SDL_Rect& destination);
+
     public:
         virtual ~graphics();
         SDL_Renderer* get_renderer() { return renderer; }
 
+        /// <summary>
+        /// The textures of text drawn with draw_text, see text_cache::get_statistics for how often text is reused
+        /// </summary>
+        text_cache& get_text_cache() { return texts; }
+        const text_cache& get_text_cache() const { return texts; }
+
         void set_color(uint32_t color);
         uint32_t get_color() const;
         SDL_Color get_sdl_color() const;
@@ -52,6 +63,23 @@ namespace isometric::rendering {
             content_align align = content_align::top_left,
             bool wrap = false
         );
+
+        // The same as above, without looking the font up by name:
+
+        void draw_text(
+            const isometric::assets::font& font, int point_size,
+            const std::string& text,
+            const SDL_Point& point,
+            content_align align = content_align::top_left
+        );
+
+        void draw_text(
+            const isometric::assets::font& font, int point_size,
+            const std::string& text,
+            const SDL_Rect& destination,
+            content_align align = content_align::top_left,
+            bool wrap = false
+        );
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,301 @@
+#include "render_layer.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace isometric::rendering;
+
+render_counters render_layer::current_frame;
+render_counters render_layer::last_frame;
+SDL_Texture* render_layer::last_texture = nullptr;
+bool render_layer::drawing_to_screen = true;
+SDL_FRect render_layer::screen_bounds = { 0.0f, 0.0f, 0.0f, 0.0f };
+SDL_Renderer* render_layer::state_renderer = nullptr;
+bool render_layer::draw_color_known = false;
+SDL_Color render_layer::draw_color = { 0, 0, 0, 0 };
+bool render_layer::clip_rect_known = false;
+bool render_layer::clipping = false;
+SDL_Rect render_layer::clip_rect = { 0, 0, 0, 0 };
+
+namespace {
+
+    double triangle_area(const SDL_FPoint& a, const SDL_FPoint& b, const SDL_FPoint& c)
+    {
+        return std::abs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) * 0.5;
+    }
+
+    float overlap(float min_a, float max_a, float min_b, float max_b)
+    {
+        return std::max(0.0f, std::min(max_a, max_b) - std::max(min_a, min_b));
+    }
+}
+
+void render_layer::count_draw(SDL_Texture* texture, uint64_t vertex_count)
+{
+    current_frame.draw_calls++;
+    current_frame.vertices += vertex_count;
+
+    if (texture != last_texture)
+    {
+        current_frame.texture_switches++;
+        last_texture = texture;
+    }
+}
+
+void render_layer::count_covered(float min_x, float min_y, float max_x, float max_y, double area)
+{
+    // Only what lands on the screen adds to overdraw, drawing into a texture is counted when the texture is drawn:
+    if (!drawing_to_screen || area <= 0.0) return;
+
+    const SDL_FRect bounds = clipping ? SDL_FRect{
+        static_cast<float>(clip_rect.x), static_cast<float>(clip_rect.y),
+        static_cast<float>(clip_rect.w), static_cast<float>(clip_rect.h)
+    } : screen_bounds;
+
+    // Until the first frame has ended the size of the screen isn't known, so nothing is clipped:
+    if (bounds.w <= 0.0f || bounds.h <= 0.0f)
+    {
+        current_frame.covered_pixels += area;
+        return;
+    }
+
+    // The part of the bounding box that is visible is taken as the part of the area that is visible:
+    const float visible_x = overlap(min_x, max_x, bounds.x, bounds.x + bounds.w);
+    const float visible_y = overlap(min_y, max_y, bounds.y, bounds.y + bounds.h);
+    const double bounds_area = static_cast<double>(max_x - min_x) * (max_y - min_y);
+
+    current_frame.covered_pixels += area * (static_cast<double>(visible_x) * visible_y / bounds_area);
+}
+
+int render_layer::draw_geometry(
+    SDL_Renderer* renderer,
+    SDL_Texture* texture,
+    const SDL_Vertex* vertices, int vertex_count,
+    const int* indices, int index_count
+)
+{
+    const int triangle_vertex_count = indices ? index_count : vertex_count;
+    count_draw(texture, static_cast<uint64_t>(triangle_vertex_count));
+
+    if (drawing_to_screen)
+    {
+        for (int i = 0; i + 2 < triangle_vertex_count; i += 3)
+        {
+            const SDL_FPoint& a = vertices[indices ? indices[i] : i].position;
+            const SDL_FPoint& b = vertices[indices ? indices[i + 1] : i + 1].position;
+            const SDL_FPoint& c = vertices[indices ? indices[i + 2] : i + 2].position;
+
+            count_covered(
+                std::min({ a.x, b.x, c.x }), std::min({ a.y, b.y, c.y }),
+                std::max({ a.x, b.x, c.x }), std::max({ a.y, b.y, c.y }),
+                triangle_area(a, b, c)
+            );
+        }
+    }
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    return SDL_RenderGeometry(renderer, texture, vertices, vertex_count, indices, index_count);
+#else
+    return SDL_Unsupported();
+#endif
+}
+
+int render_layer::copy(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* source, const SDL_Rect* dest)
+{
+    count_draw(texture, 6);
+
+    if (dest)
+    {
+        const float x = static_cast<float>(dest->x);
+        const float y = static_cast<float>(dest->y);
+        count_covered(x, y, x + dest->w, y + dest->h, static_cast<double>(dest->w) * dest->h);
+    }
+
+    return SDL_RenderCopy(renderer, texture, source, dest);
+}
+
+int render_layer::copy(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* source, const SDL_FRect* dest)
+{
+    count_draw(texture, 6);
+
+    if (dest)
+    {
+        count_covered(dest->x, dest->y, dest->x + dest->w, dest->y + dest->h, static_cast<double>(dest->w) * dest->h);
+    }
+
+    return SDL_RenderCopyF(renderer, texture, source, dest);
+}
+
+int render_layer::fill_rect(SDL_Renderer* renderer, const SDL_FRect* rect)
+{
+    count_draw(nullptr, 6);
+
+    if (rect)
+    {
+        count_covered(rect->x, rect->y, rect->x + rect->w, rect->y + rect->h, static_cast<double>(rect->w) * rect->h);
+    }
+
+    return SDL_RenderFillRectF(renderer, rect);
+}
+
+int render_layer::clear(SDL_Renderer* renderer)
+{
+    // A clear is a draw call, but it doesn't use a texture and it's never counted as overdraw:
+    current_frame.draw_calls++;
+
+    return SDL_RenderClear(renderer);
+}
+
+void render_layer::track_renderer(SDL_Renderer* renderer)
+{
+    if (renderer == state_renderer) return;
+
+    state_renderer = renderer;
+    invalidate_state();
+}
+
+void render_layer::invalidate_state()
+{
+    draw_color_known = false;
+    clip_rect_known = false;
+    clipping = false;
+    clip_rect = SDL_Rect{ 0, 0, 0, 0 };
+}
+
+int render_layer::set_draw_color(SDL_Renderer* renderer, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    track_renderer(renderer);
+
+    if (draw_color_known && draw_color.r == r && draw_color.g == g && draw_color.b == b && draw_color.a == a)
+    {
+        current_frame.redundant_state_changes++;
+        return 0;
+    }
+
+    const int result = SDL_SetRenderDrawColor(renderer, r, g, b, a);
+    draw_color_known = result == 0;
+    draw_color = SDL_Color{ r, g, b, a };
+
+    current_frame.draw_color_changes++;
+    return result;
+}
+
+SDL_Color render_layer::get_draw_color(SDL_Renderer* renderer)
+{
+    track_renderer(renderer);
+
+    if (!draw_color_known && SDL_GetRenderDrawColor(renderer, &draw_color.r, &draw_color.g, &draw_color.b,
+        &draw_color.a) == 0)
+    {
+        draw_color_known = true;
+    }
+
+    return draw_color_known ? draw_color : SDL_Color{ 0, 0, 0, 0 };
+}
+
+int render_layer::set_color_mod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b)
+{
+    Uint8 current_r = 0, current_g = 0, current_b = 0;
+    if (SDL_GetTextureColorMod(texture, &current_r, &current_g, &current_b) == 0 &&
+        current_r == r && current_g == g && current_b == b)
+    {
+        current_frame.redundant_state_changes++;
+        return 0;
+    }
+
+    current_frame.color_mod_changes++;
+    return SDL_SetTextureColorMod(texture, r, g, b);
+}
+
+int render_layer::set_alpha_mod(SDL_Texture* texture, Uint8 a)
+{
+    Uint8 current_a = 0;
+    if (SDL_GetTextureAlphaMod(texture, &current_a) == 0 && current_a == a)
+    {
+        current_frame.redundant_state_changes++;
+        return 0;
+    }
+
+    current_frame.alpha_mod_changes++;
+    return SDL_SetTextureAlphaMod(texture, a);
+}
+
+int render_layer::set_blend_mode(SDL_Texture* texture, SDL_BlendMode blend_mode)
+{
+    SDL_BlendMode current_blend_mode = SDL_BLENDMODE_NONE;
+    if (SDL_GetTextureBlendMode(texture, &current_blend_mode) == 0 && current_blend_mode == blend_mode)
+    {
+        current_frame.redundant_state_changes++;
+        return 0;
+    }
+
+    current_frame.blend_mode_changes++;
+    return SDL_SetTextureBlendMode(texture, blend_mode);
+}
+
+int render_layer::set_draw_blend_mode(SDL_Renderer* renderer, SDL_BlendMode blend_mode)
+{
+    SDL_BlendMode current_blend_mode = SDL_BLENDMODE_NONE;
+    if (SDL_GetRenderDrawBlendMode(renderer, &current_blend_mode) == 0 && current_blend_mode == blend_mode)
+    {
+        current_frame.redundant_state_changes++;
+        return 0;
+    }
+
+    current_frame.blend_mode_changes++;
+    return SDL_SetRenderDrawBlendMode(renderer, blend_mode);
+}
+
+int render_layer::set_clip_rect(SDL_Renderer* renderer, const SDL_Rect* rect)
+{
+    track_renderer(renderer);
+
+    if (clip_rect_known && clipping == (rect != nullptr) && (!rect ||
+        (rect->x == clip_rect.x && rect->y == clip_rect.y && rect->w == clip_rect.w && rect->h == clip_rect.h)))
+    {
+        current_frame.redundant_state_changes++;
+        return 0;
+    }
+
+    const int result = SDL_RenderSetClipRect(renderer, rect);
+    clip_rect_known = result == 0;
+    clipping = rect != nullptr;
+    if (rect) clip_rect = *rect;
+
+    current_frame.clip_rect_changes++;
+    return result;
+}
+
+int render_layer::set_target(SDL_Renderer* renderer, SDL_Texture* texture)
+{
+    track_renderer(renderer);
+
+    current_frame.target_changes++;
+    drawing_to_screen = texture == nullptr;
+
+    // Each target has its own clip rect in SDL, the screen's is restored when it's the target again. Until it's set
+    // again nothing is clipped as far as overdraw is concerned:
+    clip_rect_known = false;
+    clipping = false;
+    clip_rect = SDL_Rect{ 0, 0, 0, 0 };
+
+    return SDL_SetRenderTarget(renderer, texture);
+}
+
+void render_layer::present(SDL_Renderer* renderer)
+{
+    SDL_RenderPresent(renderer);
+    end_frame(renderer);
+}
+
+void render_layer::end_frame(SDL_Renderer* renderer)
+{
+    int width = 0, height = 0;
+    if (renderer) SDL_GetRendererOutputSize(renderer, &width, &height);
+
+    current_frame.screen_pixels = static_cast<double>(width) * height;
+    screen_bounds = SDL_FRect{ 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height) };
+
+    last_frame = current_frame;
+    current_frame = render_counters{};
+    last_texture = nullptr;
+}
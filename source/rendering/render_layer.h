@@ -0,0 +1,112 @@
+#pragma once
+#include <SDL.h>
+#include <cstdint>
+
+namespace isometric::rendering {
+
+    /// <summary>
+    /// What was submitted to the renderer over one frame, see render_layer
+    /// </summary>
+    struct render_counters
+    {
+        uint64_t draw_calls = 0;            // Geometry, copies, fills and clears
+        uint64_t texture_switches = 0;      // Draw calls that use a different texture than the draw call before them
+        uint64_t color_mod_changes = 0;
+        uint64_t alpha_mod_changes = 0;
+        uint64_t blend_mode_changes = 0;
+        uint64_t draw_color_changes = 0;
+        uint64_t clip_rect_changes = 0;
+        uint64_t target_changes = 0;
+        uint64_t redundant_state_changes = 0;   // Calls that would have set state to what it already was, not made
+        uint64_t vertices = 0;              // Triangle vertices, a copy or a filled rectangle counts as 6
+        double covered_pixels = 0.0;        // Area of everything drawn to the screen, within the clip rect
+        double screen_pixels = 0.0;         // Area of the screen when the frame ended
+
+        /// <returns>
+        /// How many times each pixel of the screen was drawn on average. This is an estimate: triangles are clipped
+        /// by their bounding box, and transparent pixels count as drawn.
+        /// </returns>
+        double get_overdraw() const { return screen_pixels > 0.0 ? covered_pixels / screen_pixels : 0.0; }
+    };
+
+    /// <summary>
+    /// A thin layer over the SDL renderer calls the engine makes, which forwards each call to SDL and counts it.
+    /// The counts are kept for the frame being drawn and the last frame that was presented, so a regression can be
+    /// told apart as either more work before submitting (culling, sorting) or more being submitted.
+    ///
+    /// State changes that wouldn't change anything are filtered out, as many backends flush their batch of draw calls
+    /// on every state change even if nothing changed. Texture color mods, alpha mods and blend modes are compared
+    /// with what the texture has (so a destroyed texture can't leave stale state behind), the draw color and clip
+    /// rect are shadowed here. Call invalidate_state after changing either through SDL directly.
+    ///
+    /// Like the SDL renderer, this may only be used from the thread that renders.
+    /// </summary>
+    class render_layer
+    {
+    private:
+        static render_counters current_frame;
+        static render_counters last_frame;
+        static SDL_Texture* last_texture;
+        static bool drawing_to_screen;
+        static SDL_FRect screen_bounds;     // Empty until the first frame ends
+
+        // Shadowed renderer state, only valid for state_renderer. The clip rect is the screen's, it's also what
+        // overdraw is clipped to:
+        static SDL_Renderer* state_renderer;
+        static bool draw_color_known;
+        static SDL_Color draw_color;
+        static bool clip_rect_known;
+        static bool clipping;
+        static SDL_Rect clip_rect;
+
+        static void track_renderer(SDL_Renderer* renderer);
+
+        static void count_draw(SDL_Texture* texture, uint64_t vertex_count);
+        static void count_covered(float min_x, float min_y, float max_x, float max_y, double area);
+
+    public:
+        static int draw_geometry(
+            SDL_Renderer* renderer,
+            SDL_Texture* texture,
+            const SDL_Vertex* vertices, int vertex_count,
+            const int* indices, int index_count
+        );
+
+        static int copy(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* source, const SDL_Rect* dest);
+        static int copy(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* source, const SDL_FRect* dest);
+        static int fill_rect(SDL_Renderer* renderer, const SDL_FRect* rect);
+        static int clear(SDL_Renderer* renderer);
+
+        static int set_draw_color(SDL_Renderer* renderer, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+        static SDL_Color get_draw_color(SDL_Renderer* renderer);
+        static int set_color_mod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b);
+        static int set_alpha_mod(SDL_Texture* texture, Uint8 a);
+        static int set_blend_mode(SDL_Texture* texture, SDL_BlendMode blend_mode);
+        static int set_draw_blend_mode(SDL_Renderer* renderer, SDL_BlendMode blend_mode);
+        static int set_clip_rect(SDL_Renderer* renderer, const SDL_Rect* rect);
+        static int set_target(SDL_Renderer* renderer, SDL_Texture* texture);
+
+        /// <summary>
+        /// Forget the shadowed draw color and clip rect, so the next calls to set them are always made
+        /// </summary>
+        static void invalidate_state();
+
+        /// <summary>
+        /// Present the frame and start counting the next one
+        /// </summary>
+        static void present(SDL_Renderer* renderer);
+
+        /// <summary>
+        /// Keep the counts of the frame drawn so far as the last frame's and start counting the next one, present
+        /// does this for you
+        /// </summary>
+        static void end_frame(SDL_Renderer* renderer);
+
+        /// <returns>The counts of the last presented frame</returns>
+        static const render_counters& get_last_frame() { return last_frame; }
+
+        /// <returns>The counts of the frame being drawn so far</returns>
+        static const render_counters& get_current_frame() { return current_frame; }
+    };
+
+}
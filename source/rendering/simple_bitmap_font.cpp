@@ -1,4 +1,5 @@
 #include "simple_bitmap_font.h"
+#include "render_layer.h"
 #include <SDL_ttf.h>
 #include <vector>
 #include <tuple>
@@ -144,8 +145,8 @@ void simple_bitmap_font::draw(
     for (const auto& texture_info : font_info.textures)
     {
         SDL_Texture* texture = std::get<0>(texture_info);
-        SDL_SetTextureColorMod(texture, current_color.r, current_color.g, current_color.b);
-        SDL_SetTextureAlphaMod(texture, current_color.a);
+        render_layer::set_color_mod(texture, current_color.r, current_color.g, current_color.b);
+        render_layer::set_alpha_mod(texture, current_color.a);
     }
 
     // To keep up with the current glyph drawing position:
@@ -204,7 +205,7 @@ void simple_bitmap_font::draw(
             SDL_Texture* texture = std::get<0>(font_info.textures[info.texture_index]);
             if (texture)
             {
-                SDL_RenderCopy(renderer, texture, &info.srcrect, &glyph_dstrect);
+                render_layer::copy(renderer, texture, &info.srcrect, &glyph_dstrect);
             }
         }
 
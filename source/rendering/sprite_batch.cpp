@@ -0,0 +1,74 @@
+#include "sprite_batch.h"
+#include <algorithm>
+#include <functional>
+
+using namespace isometric;
+using namespace isometric::rendering;
+
+void sprite_batch::clear()
+{
+    sprites.clear();
+    batch.clear();
+}
+
+void sprite_batch::add(
+    SDL_Texture* texture,
+    const SDL_Rect& source_rect,
+    const SDL_FRect& dest_rect,
+    const SDL_Color& color,
+    float depth
+)
+{
+    sprites.push_back(sprite{ texture, source_rect, dest_rect, color, depth });
+}
+
+size_t sprite_batch::submit(SDL_Renderer* renderer, sprite_sort_mode sort_mode)
+{
+    if (sprites.empty()) return 0;
+
+    // Sprites of the same texture end up next to each other, which geometry_batch turns into a single draw call:
+    const std::less<SDL_Texture*> texture_less;
+
+    if (sort_mode == sprite_sort_mode::depth)
+    {
+        std::stable_sort(sprites.begin(), sprites.end(), [&](const sprite& a, const sprite& b) {
+            if (a.depth != b.depth) return a.depth < b.depth;
+            return texture_less(a.texture, b.texture);
+        });
+    }
+    else
+    {
+        std::stable_sort(sprites.begin(), sprites.end(), [&](const sprite& a, const sprite& b) {
+            return texture_less(a.texture, b.texture);
+        });
+    }
+
+    // Only query a texture's size when the texture changes, after sorting that's once per texture (or depth run):
+    SDL_Texture* texture = nullptr;
+    SDL_Point texture_size{ 0, 0 };
+
+    for (const sprite& batch_sprite : sprites)
+    {
+        if (batch_sprite.texture && batch_sprite.texture != texture)
+        {
+            texture = batch_sprite.texture;
+            texture_size = SDL_Point{ 0, 0 };
+
+            if (SDL_QueryTexture(texture, nullptr, nullptr, &texture_size.x, &texture_size.y) != 0)
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to query a sprite texture: %s", SDL_GetError());
+            }
+        }
+
+        SDL_Rect source_rect = batch_sprite.source_rect;
+        if (source_rect.w <= 0 || source_rect.h <= 0)
+        {
+            source_rect = SDL_Rect{ 0, 0, texture_size.x, texture_size.y };
+        }
+
+        batch.add_quad(batch_sprite.texture, source_rect, texture_size, batch_sprite.dest_rect, batch_sprite.color);
+    }
+
+    sprites.clear();
+    return batch.submit(renderer);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+#include "geometry_batch.h"
+#include "../enumerations/sprite_sort_mode.h"
+
+namespace isometric::rendering {
+
+    /// <summary>
+    /// Collects sprites from any number of objects over a frame and draws them all at once. Unlike geometry_batch,
+    /// sprites don't have to be added in draw order: they're sorted by depth (and then by texture) when submitted,
+    /// so a crowd of units sharing an atlas is drawn with a handful of draw calls rather than one per unit.
+    /// </summary>
+    class sprite_batch
+    {
+    private:
+        struct sprite
+        {
+            SDL_Texture* texture = nullptr;
+            SDL_Rect source_rect = { 0 };
+            SDL_FRect dest_rect = { 0 };
+            SDL_Color color = { 0 };
+            float depth = 0.0f;
+        };
+
+        std::vector<sprite> sprites;
+        geometry_batch batch;
+
+    public:
+        /// <summary>
+        /// Remove every sprite from the batch, without releasing its memory
+        /// </summary>
+        void clear();
+
+        /// <summary>
+        /// Add a sprite to the batch, nothing is drawn until submit()
+        /// </summary>
+        /// <param name="texture">The texture to draw from, or nullptr to fill dest_rect with color</param>
+        /// <param name="source_rect">Where the sprite is in the texture, an empty rect uses the whole texture</param>
+        /// <param name="dest_rect">Where to draw the sprite</param>
+        /// <param name="color">Multiplied with the texture, use an alpha below 255 for transparency</param>
+        /// <param name="depth">Sprites with a lower depth are drawn first, such as the y position of the sprite</param>
+        void add(
+            SDL_Texture* texture,
+            const SDL_Rect& source_rect,
+            const SDL_FRect& dest_rect,
+            const SDL_Color& color = SDL_Color{ 255, 255, 255, 255 },
+            float depth = 0.0f
+        );
+
+        size_t get_sprite_count() const { return sprites.size(); }
+
+        /// <summary>
+        /// Draw every sprite in the batch and then clear it
+        /// </summary>
+        /// <param name="sort_mode">How sprites are ordered, sprites that compare equal keep the order they were added</param>
+        /// <returns>The number of draw calls that were made</returns>
+        size_t submit(SDL_Renderer* renderer, sprite_sort_mode sort_mode = sprite_sort_mode::depth);
+    };
+
+}
@@ -0,0 +1,283 @@
+#include "text_cache.h"
+#include "render_layer.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+using namespace isometric::rendering;
+
+size_t text_cache::key_hash::operator()(const key& text_key) const
+{
+    size_t hash = std::hash<std::string_view>()(text_key.text);
+    hash ^= std::hash<const void*>()(text_key.font) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int>()(text_key.point_size) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int>()(text_key.wrap_width) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+text_cache::text_cache(SDL_Renderer* renderer, size_t max_entries, size_t max_pages)
+    : renderer(renderer), max_entries(std::max<size_t>(max_entries, 1)), max_pages(max_pages)
+{
+
+}
+
+text_cache::key text_cache::get_key(const entry& cached_entry)
+{
+    return key{ cached_entry.font, cached_entry.point_size, cached_entry.text, cached_entry.wrap_width };
+}
+
+const text_cache::cached_text* text_cache::get(TTF_Font* font, int point_size, const std::string& text, int wrap_width)
+{
+    if (text.empty()) return nullptr; // SDL_ttf can't render empty text, and there's nothing to draw anyway
+
+    use_count++;
+
+    auto found = lookup.find(key{ font, point_size, text, wrap_width });
+    if (found != lookup.end())
+    {
+        stats.hits++;
+
+        auto iter = found->second;
+        entries.splice(entries.begin(), entries, iter);
+        if (iter->page != no_page) pages[iter->page].last_used = use_count;
+
+        return &iter->texture;
+    }
+
+    stats.misses++;
+    if (!renderer || !font) return nullptr;
+
+    SDL_Surface* surface = render(font, text, wrap_width);
+    if (!surface) return nullptr;
+
+    entries.push_front(entry{ font, point_size, text, wrap_width });
+    auto new_entry = entries.begin();
+
+    const bool packed = pack(surface, *new_entry);
+    SDL_FreeSurface(surface);
+
+    if (!packed)
+    {
+        entries.erase(new_entry);
+        return nullptr;
+    }
+
+    lookup.emplace(get_key(*new_entry), new_entry);
+
+    while (entries.size() > max_entries)
+    {
+        erase(std::prev(entries.end()));
+        stats.evictions++;
+    }
+
+    return &new_entry->texture;
+}
+
+SDL_Surface* text_cache::render(TTF_Font* font, const std::string& text, int wrap_width) const
+{
+    constexpr SDL_Color white = SDL_Color{ 255, 255, 255, 255 };
+
+    SDL_Surface* surface = wrap_width >= 0
+        ? TTF_RenderUTF8_Blended_Wrapped(font, text.c_str(), white, static_cast<Uint32>(wrap_width))
+        : TTF_RenderUTF8_Blended(font, text.c_str(), white);
+
+    if (!surface)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to render text '%s': %s", text.c_str(), TTF_GetError());
+    }
+
+    return surface;
+}
+
+bool text_cache::pack(SDL_Surface* surface, entry& new_entry)
+{
+    const int width = surface->w;
+    const int height = surface->h;
+
+    // Text that would take up most of a page, such as a wrapped paragraph, isn't worth packing:
+    const bool fits_page = width + padding * 2 <= page_size / 2 && height + padding * 2 <= page_size / 2;
+
+    if (fits_page && max_pages > 0)
+    {
+        SDL_Rect rect{};
+        size_t page_index = 0;
+
+        while (page_index < pages.size() && !pack_into(page_index, width, height, rect))
+        {
+            page_index++;
+        }
+
+        if (page_index == pages.size() && pages.size() < max_pages)
+        {
+            SDL_Texture* texture = SDL_CreateTexture(
+                renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, page_size, page_size
+            );
+
+            if (texture)
+            {
+                render_layer::set_blend_mode(texture, SDL_BLENDMODE_BLEND);
+                pages.push_back(page{ texture });
+                pack_into(page_index, width, height, rect);
+            }
+            else
+            {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to create a text cache page: %s", SDL_GetError());
+            }
+        }
+        else if (page_index == pages.size() && !pages.empty())
+        {
+            // Every page is full, so the one that was used least recently is emptied for the new text:
+            auto oldest = std::min_element(pages.begin(), pages.end(), [](const page& a, const page& b) {
+                return a.last_used < b.last_used;
+            });
+
+            page_index = static_cast<size_t>(std::distance(pages.begin(), oldest));
+            empty_page(page_index);
+            stats.page_evictions++;
+
+            pack_into(page_index, width, height, rect);
+        }
+
+        if (page_index < pages.size())
+        {
+            // The text is uploaded with its padding, so that whatever was in the page before is cleared around it:
+            SDL_Surface* padded = SDL_CreateRGBSurfaceWithFormat(0, rect.w, rect.h, 32, SDL_PIXELFORMAT_ARGB8888);
+
+            if (padded)
+            {
+                SDL_Rect text_rect{ padding, padding, width, height };
+                SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+                SDL_BlitSurface(surface, nullptr, padded, &text_rect);
+
+                page& text_page = pages[page_index];
+                const bool uploaded = SDL_UpdateTexture(text_page.texture, &rect, padded->pixels, padded->pitch) == 0;
+                SDL_FreeSurface(padded);
+
+                if (uploaded)
+                {
+                    text_page.entry_count++;
+                    text_page.last_used = use_count;
+
+                    new_entry.page = page_index;
+                    new_entry.texture = cached_text{
+                        text_page.texture,
+                        SDL_Rect{ rect.x + padding, rect.y + padding, width, height }
+                    };
+
+                    return true;
+                }
+            }
+        }
+    }
+
+    // Too large for a page, or the page couldn't be used, so the text gets a texture of its own:
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (!texture)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to create a text texture: %s", SDL_GetError());
+        return false;
+    }
+
+    new_entry.page = no_page;
+    new_entry.texture = cached_text{ texture, SDL_Rect{ 0, 0, width, height } };
+    return true;
+}
+
+bool text_cache::pack_into(size_t page_index, int width, int height, SDL_Rect& rect)
+{
+    page& text_page = pages[page_index];
+    const int padded_width = width + padding * 2;
+    const int padded_height = height + padding * 2;
+
+    // The shortest row that the text fits in, so that short text doesn't use up the space in tall rows:
+    shelf* best = nullptr;
+    for (shelf& row : text_page.shelves)
+    {
+        if (row.height >= padded_height && page_size - row.next_x >= padded_width &&
+            (!best || row.height < best->height))
+        {
+            best = &row;
+        }
+    }
+
+    if (!best)
+    {
+        if (text_page.next_shelf_y + padded_height > page_size) return false;
+
+        text_page.shelves.push_back(shelf{ text_page.next_shelf_y, padded_height, 0 });
+        text_page.next_shelf_y += padded_height;
+        best = &text_page.shelves.back();
+    }
+
+    rect = SDL_Rect{ best->next_x, best->y, padded_width, padded_height };
+    best->next_x += padded_width;
+    return true;
+}
+
+void text_cache::erase(std::list<entry>::iterator iter)
+{
+    lookup.erase(get_key(*iter));
+
+    if (iter->page == no_page)
+    {
+        if (iter->texture.texture) SDL_DestroyTexture(iter->texture.texture);
+    }
+    else
+    {
+        // Space in a page is only reused once everything in it is gone:
+        page& text_page = pages[iter->page];
+        if (--text_page.entry_count == 0)
+        {
+            text_page.shelves.clear();
+            text_page.next_shelf_y = 0;
+        }
+    }
+
+    entries.erase(iter);
+}
+
+void text_cache::empty_page(size_t page_index)
+{
+    for (auto iter = entries.begin(); iter != entries.end();)
+    {
+        auto next = std::next(iter);
+
+        if (iter->page == page_index)
+        {
+            erase(iter);
+            stats.evictions++;
+        }
+
+        iter = next;
+    }
+}
+
+void text_cache::forget_font(TTF_Font* font)
+{
+    for (auto iter = entries.begin(); iter != entries.end();)
+    {
+        auto next = std::next(iter);
+        if (iter->font == font) erase(iter);
+        iter = next;
+    }
+}
+
+void text_cache::clear()
+{
+    for (auto& cached_entry : entries)
+    {
+        if (cached_entry.page == no_page && cached_entry.texture.texture)
+        {
+            SDL_DestroyTexture(cached_entry.texture.texture);
+        }
+    }
+
+    for (auto& text_page : pages)
+    {
+        if (text_page.texture) SDL_DestroyTexture(text_page.texture);
+    }
+
+    lookup.clear();
+    entries.clear();
+    pages.clear();
+}
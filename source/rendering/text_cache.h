@@ -0,0 +1,141 @@
+#pragma once
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+namespace isometric::rendering {
+
+    /// <summary>
+    /// Keeps rendered text as textures, so that drawing a string that was drawn before is a single texture copy
+    /// instead of rasterizing it with SDL_ttf and uploading it again.
+    ///
+    /// Text is rendered in white (color it with the texture's color and alpha mods) and packed into shared atlas pages
+    /// with a row (shelf) packer, text too large for a page gets a texture of its own. Once max_entries strings are
+    /// cached the least recently used one is forgotten, and once every page is full the least recently used page is
+    /// emptied for the new text.
+    ///
+    /// Textures belong to the renderer they were created with and are freed along with it, clear() frees them sooner.
+    /// </summary>
+    class text_cache
+    {
+    public:
+        static constexpr size_t default_max_entries = 512;
+        static constexpr size_t default_max_pages = 4;
+        static constexpr int page_size = 1024;
+        static constexpr int padding = 1;           // Between packed strings, so filtering never samples a neighbour
+
+        struct cached_text
+        {
+            SDL_Texture* texture = nullptr;         // The atlas page, or the text's own texture
+            SDL_Rect source_rect = { 0 };           // Where the text is in the texture
+        };
+
+        struct statistics
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;                 // Strings that were forgotten to make room
+            uint64_t page_evictions = 0;            // Pages that were emptied to make room
+        };
+
+    private:
+        static constexpr size_t no_page = static_cast<size_t>(-1);
+
+        struct entry
+        {
+            TTF_Font* font = nullptr;
+            int point_size = 0;
+            std::string text;
+            int wrap_width = 0;
+            size_t page = no_page;
+            cached_text texture;
+        };
+
+        // Refers to the text of an entry, which stays where it is in the list for as long as the entry exists:
+        struct key
+        {
+            TTF_Font* font;
+            int point_size;
+            std::string_view text;
+            int wrap_width;
+
+            bool operator==(const key& other) const = default;
+        };
+
+        struct key_hash
+        {
+            size_t operator()(const key& text_key) const;
+        };
+
+        struct shelf
+        {
+            int y = 0;
+            int height = 0;
+            int next_x = 0;
+        };
+
+        struct page
+        {
+            SDL_Texture* texture = nullptr;
+            std::vector<shelf> shelves;
+            int next_shelf_y = 0;
+            size_t entry_count = 0;
+            uint64_t last_used = 0;
+        };
+
+        SDL_Renderer* renderer = nullptr;
+        size_t max_entries = default_max_entries;
+        size_t max_pages = default_max_pages;
+
+        std::list<entry> entries;                   // Most recently used first
+        std::unordered_map<key, std::list<entry>::iterator, key_hash> lookup;
+        std::vector<page> pages;
+        uint64_t use_count = 0;
+        statistics stats;
+
+        static key get_key(const entry& cached_entry);
+
+        SDL_Surface* render(TTF_Font* font, const std::string& text, int wrap_width) const;
+        bool pack(SDL_Surface* surface, entry& new_entry);
+        bool pack_into(size_t page_index, int width, int height, SDL_Rect& rect);
+        void erase(std::list<entry>::iterator iter);
+        void empty_page(size_t page_index);
+
+    public:
+        explicit text_cache(
+            SDL_Renderer* renderer,
+            size_t max_entries = default_max_entries,
+            size_t max_pages = default_max_pages
+        );
+
+        /// <summary>
+        /// Gets the texture of some text, rendering it first if it isn't cached
+        /// </summary>
+        /// <param name="wrap_width">Wrap lines longer than this many pixels, or below 0 to not wrap</param>
+        /// <returns>
+        /// The texture and where the text is in it, or nullptr if the text couldn't be rendered. Only valid until the
+        /// next call, which may evict it.
+        /// </returns>
+        const cached_text* get(TTF_Font* font, int point_size, const std::string& text, int wrap_width = -1);
+
+        /// <summary>
+        /// Forget every string rendered with a font, call this before the font is closed
+        /// </summary>
+        void forget_font(TTF_Font* font);
+
+        /// <summary>
+        /// Destroy every cached texture, the renderer they were created with must still exist
+        /// </summary>
+        void clear();
+
+        size_t get_entry_count() const { return entries.size(); }
+        size_t get_page_count() const { return pages.size(); }
+        const statistics& get_statistics() const { return stats; }
+        void reset_statistics() { stats = statistics{}; }
+    };
+
+}
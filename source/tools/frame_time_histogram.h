@@ -0,0 +1,155 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+namespace isometric::tools {
+
+    /// <summary>
+    /// Counts frame times into logarithmic buckets (like an HDR histogram), so percentiles can be read back at any
+    /// time without keeping every frame. Times are kept in whole microseconds: below 256 us every microsecond has its
+    /// own bucket, above that each doubling of the time is split into 128 buckets, so a percentile is never more than
+    /// 1% above the real frame time. Recording a frame is a few integer operations whatever the frame count.
+    /// </summary>
+    class frame_time_histogram
+    {
+    private:
+        static constexpr unsigned sub_bucket_bits = 8;
+        static constexpr uint64_t linear_bucket_count = 1ull << sub_bucket_bits;           // One per microsecond
+        static constexpr uint64_t sub_bucket_count = linear_bucket_count / 2;              // Per doubling above that
+        static constexpr unsigned max_exponent = 31;                                       // Up to about 71 minutes
+        static constexpr uint64_t max_microseconds = (1ull << (max_exponent + 1)) - 1;
+        static constexpr size_t bucket_count =
+            linear_bucket_count + (max_exponent - sub_bucket_bits + 1) * sub_bucket_count;
+
+        std::array<uint32_t, bucket_count> buckets{};
+        uint64_t count = 0;
+        uint64_t total_microseconds = 0;
+        uint64_t min_microseconds = 0;
+        uint64_t max_microseconds_seen = 0;
+
+        double budget_ms = 1000.0 / 60.0;
+        uint64_t over_budget_count = 0;         // Frames slower than the budget
+        uint64_t over_double_budget_count = 0;  // Frames that took long enough to miss at least one whole frame
+
+        static size_t bucket_of(uint64_t microseconds)
+        {
+            if (microseconds < linear_bucket_count) return static_cast<size_t>(microseconds);
+
+            // The top sub_bucket_bits bits of the time pick the bucket within its power of two:
+            const unsigned exponent = static_cast<unsigned>(std::bit_width(microseconds)) - 1;
+            const uint64_t sub_bucket = microseconds >> (exponent - sub_bucket_bits + 1);
+
+            return static_cast<size_t>(
+                linear_bucket_count + (exponent - sub_bucket_bits) * sub_bucket_count + (sub_bucket - sub_bucket_count)
+            );
+        }
+
+        /// <returns>The highest time in microseconds that goes into a bucket</returns>
+        static uint64_t bucket_upper_bound(size_t bucket)
+        {
+            if (bucket < linear_bucket_count) return bucket;
+
+            const uint64_t index = bucket - linear_bucket_count;
+            const unsigned shift = static_cast<unsigned>(index / sub_bucket_count) + 1;
+            const uint64_t sub_bucket = sub_bucket_count + index % sub_bucket_count;
+
+            return ((sub_bucket + 1) << shift) - 1;
+        }
+
+        static double to_ms(uint64_t microseconds) { return static_cast<double>(microseconds) / 1000.0; }
+
+    public:
+
+        /// <summary>
+        /// Record how long a frame took
+        /// </summary>
+        /// <param name="frame_time">The duration of the frame in seconds</param>
+        void record(double frame_time)
+        {
+            const double microseconds = std::round(std::max(frame_time, 0.0) * 1000000.0);
+            const uint64_t value = microseconds >= static_cast<double>(max_microseconds)
+                ? max_microseconds
+                : static_cast<uint64_t>(microseconds);
+
+            buckets[bucket_of(value)]++;
+
+            if (count == 0 || value < min_microseconds) min_microseconds = value;
+            if (value > max_microseconds_seen) max_microseconds_seen = value;
+
+            count++;
+            total_microseconds += value;
+
+            const double ms = to_ms(value);
+            if (ms > budget_ms) over_budget_count++;
+            if (ms > budget_ms * 2.0) over_double_budget_count++;
+        }
+
+        /// <summary>
+        /// Forget every recorded frame and start a new window, the budget is kept
+        /// </summary>
+        void reset()
+        {
+            buckets.fill(0);
+            count = 0;
+            total_microseconds = 0;
+            min_microseconds = 0;
+            max_microseconds_seen = 0;
+            over_budget_count = 0;
+            over_double_budget_count = 0;
+        }
+
+        /// <summary>
+        /// Set the longest a frame may take before it counts as a stutter, frames recorded before the change keep
+        /// being counted against the old budget until the next reset
+        /// </summary>
+        void set_budget_ms(double budget) { budget_ms = budget; }
+        double get_budget_ms() const { return budget_ms; }
+
+        uint64_t get_count() const { return count; }
+
+        /// <returns>Number of frames that took longer than the budget</returns>
+        uint64_t get_over_budget_count() const { return over_budget_count; }
+
+        /// <returns>Number of frames that took longer than twice the budget, so a whole frame was missed</returns>
+        uint64_t get_over_double_budget_count() const { return over_double_budget_count; }
+
+        /// <summary>
+        /// Gets the time that the given percentage of frames were as fast as or faster than, for example 99 for the
+        /// 99th percentile. The result may be up to 1% above the real time, but never above the slowest frame.
+        /// </summary>
+        /// <param name="percentile">Between 0 and 100</param>
+        /// <returns>Milliseconds, or 0 if nothing has been recorded</returns>
+        double get_percentile_ms(double percentile) const
+        {
+            if (count == 0) return 0.0;
+
+            const double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+            const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * count)));
+
+            uint64_t seen = 0;
+            for (size_t bucket = 0; bucket < bucket_count; bucket++)
+            {
+                seen += buckets[bucket];
+                if (seen >= rank) return to_ms(std::min(bucket_upper_bound(bucket), max_microseconds_seen));
+            }
+
+            return to_ms(max_microseconds_seen);
+        }
+
+        double get_min_ms() const { return to_ms(min_microseconds); }
+        double get_max_ms() const { return to_ms(max_microseconds_seen); }
+
+        /// <returns>The average frame time in milliseconds, or 0 if nothing has been recorded</returns>
+        double get_mean_ms() const
+        {
+            return count > 0 ? to_ms(total_microseconds) / static_cast<double>(count) : 0.0;
+        }
+
+        /// <returns>Total time of every recorded frame in seconds</returns>
+        double get_total_sec() const { return static_cast<double>(total_microseconds) / 1000000.0; }
+    };
+
+}
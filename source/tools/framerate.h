@@ -2,41 +2,25 @@
 #include <vector>
 #include <numeric>
 #include <functional>
+#include "frame_time_histogram.h"
 
 namespace isometric::tools {
 
     class framerate {
     private:
         double current = 0.0;
-        double minimum = 0.0;
-        double maximum = 0.0;
-        double overall_average = 0.0;
 
         size_t max_history = 1000;
         size_t history_cursor = 0;
         std::vector<double> history;
 
-    public:
+        // Every frame time since the last reset_window, the minimum, maximum and overall average come from here:
+        frame_time_histogram frame_times;
 
-        /// <summary>
-        /// Set the current framerate so that it can be used in calculations
-        /// </summary>
-        /// <param name="fps">Current frames per second</param>
-        void set(double fps)
+        void set_current(double fps)
         {
             current = fps;
 
-            // If the current framerate is greater or equalt to 5 and less than the minimum, set it, unless
-            // the minimum is still below 5, then it should be equivalent to current until it gets higher.
-            // 
-            // This is to prevent the minimum framerate always being super low, as that's expected when the engine
-            // is starting up or shutting down.
-            if (minimum < 5.0 || (current >= 5.0 && current < minimum)) minimum = current;
-
-            // Set the maximum framerate, unless the application is still considered starting up (that is before
-            // the framerate history has had a chance to fill up).
-            if (current > maximum && history.size() >= max_history) maximum = current;
-
             // Used to calculate the current average (not the overall average). Do this by keeping a history of past 
             // framerates.
             if (history.size() != max_history)
@@ -51,13 +35,18 @@ namespace isometric::tools {
                 history_cursor < max_history - 1
                 ? history_cursor + 1
                 : 0;
+        }
 
-            // Keep a caluclation of the overall average framerate. Ignore any values below 5 in the calculation.
-            if (overall_average <= 0.1 || current <= 5.0) overall_average = current;
-            else
-            {
-                overall_average = (overall_average + current) / 2.0;
-            }
+    public:
+
+        /// <summary>
+        /// Set the current framerate so that it can be used in calculations
+        /// </summary>
+        /// <param name="fps">Current frames per second</param>
+        void set(double fps)
+        {
+            if (fps > 0.0) frame_times.record(1.0 / fps);
+            set_current(fps);
         }
 
         /// <summary>
@@ -66,7 +55,31 @@ namespace isometric::tools {
         /// <param name="delta_time">The duration in seconds for a single frame</param>
         void set_from_delta(double delta_time)
         {
-            set(calculate(delta_time));
+            frame_times.record(delta_time);
+            set_current(calculate(delta_time));
+        }
+
+        /// <summary>
+        /// Start a new window for the minimum, maximum, overall average and frame time percentiles, such as once
+        /// loading is done so that it doesn't count against them
+        /// </summary>
+        void reset_window()
+        {
+            frame_times.reset();
+        }
+
+        /// <summary>
+        /// Set the frame time above which a frame counts as a stutter, see frame_time_histogram
+        /// </summary>
+        void set_budget(double fps)
+        {
+            if (fps > 0.0) frame_times.set_budget_ms(1000.0 / fps);
+        }
+
+        /// <returns>Every frame time since the window started, for percentiles and stutter counts</returns>
+        const frame_time_histogram& get_frame_times() const
+        {
+            return frame_times;
         }
 
         /// <returns>The curent frames per second</returns>
@@ -75,16 +88,18 @@ namespace isometric::tools {
             return current;
         }
 
-        /// <returns>The lowest frames per second for the duration of this framerate object</returns>
+        /// <returns>The frames per second of the slowest frame in the window</returns>
         double get_minimum() const
         {
-            return minimum;
+            const double slowest = frame_times.get_max_ms();
+            return slowest > 0.0 ? 1000.0 / slowest : 0.0;
         }
 
-        /// <returns>The highest frames per second for the duration of this framerate object</returns>
+        /// <returns>The frames per second of the fastest frame in the window</returns>
         double get_maximum() const
         {
-            return maximum;
+            const double fastest = frame_times.get_min_ms();
+            return fastest > 0.0 ? 1000.0 / fastest : 0.0;
         }
 
         /// <returns>The average frames per second using a history of framerates for a finite amount of frames</returns>
@@ -99,10 +114,11 @@ namespace isometric::tools {
             ) / history.size();
         }
 
-        /// <returns>The overall average frames per second for the duration of this framerate object</returns>
+        /// <returns>The frames drawn in the window divided by how long they took</returns>
         double get_overall_average() const
         {
-            return overall_average;
+            const double total = frame_times.get_total_sec();
+            return total > 0.0 ? frame_times.get_count() / total : 0.0;
         }
 
         /// <summary>
@@ -0,0 +1,261 @@
+#include "job_system.h"
+#include "profiler.h"
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace isometric::tools;
+
+namespace {
+    // Which job system and queue the current thread works for, threads that aren't workers use the shared queue:
+    thread_local const job_system* current_system = nullptr;
+    thread_local size_t current_queue = 0;
+}
+
+job_system::job_system(size_t worker_count, bool pin_workers)
+{
+    if (worker_count == 0)
+    {
+        const unsigned cores = std::thread::hardware_concurrency();
+        worker_count = cores > 1 ? cores - 1 : 0;
+    }
+
+    for (size_t i = 0; i <= worker_count; i++)
+    {
+        queues.push_back(std::make_unique<job_queue>());
+    }
+
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; i++)
+    {
+        workers.emplace_back(&job_system::worker_main, this, i, pin_workers);
+    }
+
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Job system started with %zu worker threads%s",
+        worker_count, pin_workers ? " pinned to cores" : "");
+}
+
+job_system::~job_system()
+{
+    // Jobs that are still queued are dropped, but anything running is allowed to finish:
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+
+    wake_condition.notify_all();
+
+    for (auto& worker : workers)
+    {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void job_system::pin_current_thread(size_t core_index)
+{
+#ifdef _WIN32
+    if (core_index < sizeof(DWORD_PTR) * 8)
+    {
+        SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core_index);
+    }
+#elif defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core_index, &cpu_set);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#else
+    (void)core_index;
+#endif
+}
+
+void job_system::worker_main(size_t worker_index, bool pin)
+{
+    current_system = this;
+    current_queue = worker_index;
+    profiler::set_thread_name("Worker " + std::to_string(worker_index + 1));
+
+    // Core 0 is left to the main thread:
+    if (pin) pin_current_thread(worker_index + 1);
+
+    while (true)
+    {
+        if (try_run_job()) continue;
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake_condition.wait(lock, [this]() { return stopping || queued_job_count > 0; });
+
+        if (stopping) return;
+    }
+}
+
+void job_system::enqueue(std::shared_ptr<job_handle::job_state> job)
+{
+    const size_t queue_index = current_system == this ? current_queue : workers.size();
+    job_queue& queue = *queues[queue_index];
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+
+    queued_job_count++;
+
+    // Taking the lock means a worker that just found nothing to do is either already waiting (and gets woken) or
+    // hasn't checked queued_job_count yet (and will see the new job):
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+
+    wake_condition.notify_one();
+}
+
+std::shared_ptr<job_handle::job_state> job_system::take_job()
+{
+    if (queued_job_count == 0) return nullptr;
+
+    const size_t own_index = current_system == this ? current_queue : workers.size();
+
+    // Newest job from this thread's own queue first, as its data is most likely still in the cache:
+    {
+        job_queue& queue = *queues[own_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (!queue.jobs.empty())
+        {
+            auto job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+            queued_job_count--;
+            return job;
+        }
+    }
+
+    // Otherwise steal the oldest job of another queue, starting with the queue after this one so that thieves spread
+    // out over the queues:
+    for (size_t offset = 1; offset < queues.size(); offset++)
+    {
+        job_queue& queue = *queues[(own_index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (!queue.jobs.empty())
+        {
+            auto job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+            queued_job_count--;
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+bool job_system::try_run_job()
+{
+    auto job = take_job();
+    if (!job) return false;
+
+    run_job(std::move(job));
+    return true;
+}
+
+void job_system::run_job(std::shared_ptr<job_handle::job_state> job)
+{
+    if (job->work)
+    {
+        job->work();
+        job->work = nullptr; // Release anything the work captured
+    }
+
+    finish_job(*job);
+}
+
+void job_system::finish_job(job_handle::job_state& job)
+{
+    std::vector<std::shared_ptr<job_handle::job_state>> continuations;
+
+    {
+        std::lock_guard<std::mutex> lock(job.continuation_mutex);
+        job.done.store(true, std::memory_order_release);
+        continuations.swap(job.continuations);
+    }
+
+    for (auto& continuation : continuations)
+    {
+        if (--continuation->unfinished_dependencies == 0) enqueue(std::move(continuation));
+    }
+
+    if (job.frame_scoped) unfinished_frame_job_count--;
+    unfinished_job_count--;
+}
+
+job_handle job_system::schedule(
+    std::function<void()> work,
+    std::initializer_list<job_handle> dependencies,
+    bool frame_scoped
+)
+{
+    return schedule(std::move(work), std::vector<job_handle>(dependencies), frame_scoped);
+}
+
+job_handle job_system::schedule(
+    std::function<void()> work,
+    const std::vector<job_handle>& dependencies,
+    bool frame_scoped
+)
+{
+    job_handle handle;
+    handle.state = std::make_shared<job_handle::job_state>();
+    handle.state->work = std::move(work);
+    handle.state->frame_scoped = frame_scoped;
+
+    unfinished_job_count++;
+    if (frame_scoped) unfinished_frame_job_count++;
+
+    // Dependencies that are already done don't need to be waited for, the rest run this job when they finish:
+    for (const auto& dependency : dependencies)
+    {
+        if (!dependency.state) continue;
+
+        std::lock_guard<std::mutex> lock(dependency.state->continuation_mutex);
+
+        if (!dependency.state->done.load(std::memory_order_acquire))
+        {
+            handle.state->unfinished_dependencies++;
+            dependency.state->continuations.push_back(handle.state);
+        }
+    }
+
+    if (--handle.state->unfinished_dependencies == 0) enqueue(handle.state);
+
+    return handle;
+}
+
+void job_system::wait(const job_handle& job)
+{
+    while (!job.is_done())
+    {
+        if (!try_run_job()) std::this_thread::yield();
+    }
+}
+
+void job_system::wait_for_frame()
+{
+    while (unfinished_frame_job_count > 0)
+    {
+        if (!try_run_job()) std::this_thread::yield();
+    }
+}
+
+void job_system::wait_for_all()
+{
+    while (unfinished_job_count > 0)
+    {
+        if (!try_run_job()) std::this_thread::yield();
+    }
+}
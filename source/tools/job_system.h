@@ -0,0 +1,183 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <initializer_list>
+
+namespace isometric::tools {
+
+    class job_system;
+
+    /// <summary>
+    /// A handle to a scheduled job, used to wait for it or to make other jobs depend on it. A default constructed
+    /// handle refers to no job and counts as already done.
+    /// </summary>
+    class job_handle
+    {
+        friend class job_system;
+    private:
+        struct job_state
+        {
+            std::function<void()> work;
+            std::atomic<int> unfinished_dependencies = 1;   // Starts at 1 so the job can't run while being scheduled
+            std::atomic<bool> done = false;
+            bool frame_scoped = false;
+
+            std::mutex continuation_mutex;
+            std::vector<std::shared_ptr<job_state>> continuations;  // Jobs waiting for this one to finish
+        };
+
+        std::shared_ptr<job_state> state;
+
+    public:
+        bool is_valid() const { return state != nullptr; }
+        bool is_done() const { return !state || state->done.load(std::memory_order_acquire); }
+    };
+
+    /// <summary>
+    /// A work stealing thread pool. Each worker thread has its own queue of jobs, jobs scheduled from a worker go on
+    /// its own queue (so related work stays on one core) and idle workers steal from the other end of busy workers'
+    /// queues. Threads that wait for jobs (see wait) run jobs while they wait instead of blocking, so jobs may schedule
+    /// and wait for other jobs, and a job system with no workers still works by running everything in wait.
+    ///
+    /// Jobs can depend on other jobs to form task graphs, a job only becomes runnable once every job it depends on has
+    /// finished. Frame scoped jobs are also waited for by wait_for_frame(), which the application calls once every
+    /// frame before presenting it.
+    /// </summary>
+    class job_system
+    {
+    private:
+        struct job_queue
+        {
+            std::mutex mutex;
+            std::deque<std::shared_ptr<job_handle::job_state>> jobs;
+        };
+
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<job_queue>> queues;     // One per worker, the last is shared by other threads
+
+        std::mutex sleep_mutex;
+        std::condition_variable wake_condition;
+        std::atomic<size_t> queued_job_count = 0;
+        std::atomic<size_t> unfinished_job_count = 0;
+        std::atomic<size_t> unfinished_frame_job_count = 0;
+        std::atomic<bool> stopping = false;
+
+        void worker_main(size_t worker_index, bool pin);
+        void enqueue(std::shared_ptr<job_handle::job_state> job);
+        std::shared_ptr<job_handle::job_state> take_job();
+        void run_job(std::shared_ptr<job_handle::job_state> job);
+        void finish_job(job_handle::job_state& job);
+        static void pin_current_thread(size_t core_index);
+
+    public:
+        /// <param name="worker_count">
+        /// Number of worker threads, 0 to use one less than the number of logical cores (the calling thread is the
+        /// other one)
+        /// </param>
+        /// <param name="pin_workers">Keep each worker on its own core, which keeps their caches warm</param>
+        explicit job_system(size_t worker_count = 0, bool pin_workers = false);
+
+        /// <summary>
+        /// Stops the workers once the jobs they're running are done. Jobs that are still queued or waiting on
+        /// dependencies are dropped without running, so handles to them never complete and must not be waited on
+        /// afterwards. Call wait_for_all() first to run them.
+        /// </summary>
+        ~job_system();
+
+        job_system(const job_system&) = delete;
+        job_system& operator=(const job_system&) = delete;
+
+        size_t get_worker_count() const { return workers.size(); }
+
+        /// <summary>
+        /// Schedule a job to run once every job it depends on is done
+        /// </summary>
+        /// <param name="work">The work to do, it must not throw</param>
+        /// <param name="dependencies">Jobs that have to finish before this one starts, invalid handles are ignored</param>
+        /// <param name="frame_scoped">Also wait for this job in wait_for_frame()</param>
+        job_handle schedule(
+            std::function<void()> work,
+            std::initializer_list<job_handle> dependencies = {},
+            bool frame_scoped = false
+        );
+
+        job_handle schedule(
+            std::function<void()> work,
+            const std::vector<job_handle>& dependencies,
+            bool frame_scoped = false
+        );
+
+        /// <summary>
+        /// Schedule a job that's waited for at the end of the current frame, for work that has to be finished before
+        /// the frame is presented but that nothing else in the frame waits on
+        /// </summary>
+        job_handle schedule_for_frame(std::function<void()> work, std::initializer_list<job_handle> dependencies = {})
+        {
+            return schedule(std::move(work), dependencies, true);
+        }
+
+        /// <summary>
+        /// Run jobs until a job is done
+        /// </summary>
+        void wait(const job_handle& job);
+
+        /// <summary>
+        /// Run jobs until every frame scoped job is done
+        /// </summary>
+        void wait_for_frame();
+
+        /// <summary>
+        /// Run jobs until every job is done, including jobs scheduled by jobs while waiting
+        /// </summary>
+        void wait_for_all();
+
+        /// <summary>
+        /// Run a job if one is ready
+        /// </summary>
+        /// <returns>False if there wasn't a job to run</returns>
+        bool try_run_job();
+
+        /// <summary>
+        /// Call f(first, end) for ranges of at most grain_size indices covering [begin, end), split over the workers
+        /// and the calling thread. Returns once every range is done.
+        /// </summary>
+        template<class F> void parallel_for(size_t begin, size_t end, size_t grain_size, F&& f)
+        {
+            if (end <= begin) return;
+            grain_size = std::max<size_t>(grain_size, 1);
+
+            // No point splitting work there's nobody to share with:
+            if (workers.empty() || end - begin <= grain_size)
+            {
+                f(begin, end);
+                return;
+            }
+
+            std::vector<job_handle> ranges;
+            ranges.reserve((end - begin + grain_size - 1) / grain_size);
+
+            for (size_t first = begin + grain_size; first < end; first += grain_size)
+            {
+                const size_t last = std::min(first + grain_size, end);
+                ranges.push_back(schedule([&f, first, last]() { f(first, last); }));
+            }
+
+            // The calling thread does the first range itself rather than waiting for a worker to pick it up:
+            f(begin, std::min(begin + grain_size, end));
+
+            for (const auto& range : ranges)
+            {
+                wait(range);
+            }
+        }
+    };
+
+}
@@ -0,0 +1,87 @@
+#include "mapped_file.h"
+#include <SDL.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace isometric::tools;
+
+std::unique_ptr<mapped_file> mapped_file::open(const std::string& path)
+{
+    auto file = std::unique_ptr<mapped_file>(new mapped_file);
+
+#ifdef _WIN32
+    file->file_handle = CreateFileA(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL
+    );
+
+    if (file->file_handle == INVALID_HANDLE_VALUE)
+    {
+        file->file_handle = nullptr;
+        return nullptr;
+    }
+
+    LARGE_INTEGER file_size = {};
+    if (!GetFileSizeEx(file->file_handle, &file_size) || file_size.QuadPart == 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to get the size of '%s' or it is empty", path.c_str());
+        return nullptr;
+    }
+
+    file->size = static_cast<size_t>(file_size.QuadPart);
+
+    // PAGE_WRITECOPY & FILE_MAP_COPY make the view copy-on-write:
+    file->mapping_handle = CreateFileMappingA(file->file_handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (file->mapping_handle == NULL)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create a file mapping for '%s'", path.c_str());
+        return nullptr;
+    }
+
+    file->data = static_cast<uint8_t*>(MapViewOfFile(file->mapping_handle, FILE_MAP_COPY, 0, 0, 0));
+#else
+    file->file_descriptor = ::open(path.c_str(), O_RDONLY);
+    if (file->file_descriptor < 0) return nullptr;
+
+    struct stat file_stat = {};
+    if (fstat(file->file_descriptor, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to get the size of '%s' or it is empty", path.c_str());
+        return nullptr;
+    }
+
+    file->size = static_cast<size_t>(file_stat.st_size);
+
+    // MAP_PRIVATE makes the mapping copy-on-write:
+    void* data = mmap(nullptr, file->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file->file_descriptor, 0);
+    file->data = data != MAP_FAILED ? static_cast<uint8_t*>(data) : nullptr;
+#endif
+
+    if (!file->data)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map '%s' into memory", path.c_str());
+        return nullptr;
+    }
+
+    return file;
+}
+
+mapped_file::~mapped_file()
+{
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mapping_handle) CloseHandle(mapping_handle);
+    if (file_handle) CloseHandle(file_handle);
+#else
+    if (data) munmap(data, size);
+    if (file_descriptor >= 0) close(file_descriptor);
+#endif
+}
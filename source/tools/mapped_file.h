@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace isometric::tools {
+
+    /// <summary>
+    /// A whole file mapped into memory. The mapping is copy-on-write: it can be written to, but changes are private to
+    /// this process and never reach the file. Pages are only read from disk when they are first touched.
+    /// </summary>
+    class mapped_file
+    {
+    private:
+        uint8_t* data = nullptr;
+        size_t size = 0;
+
+#ifdef _WIN32
+        void* file_handle = nullptr;
+        void* mapping_handle = nullptr;
+#else
+        int file_descriptor = -1;
+#endif
+
+        mapped_file() {}
+
+    public:
+        /// <summary>
+        /// Map a file into memory
+        /// </summary>
+        /// <param name="path">Path to an existing, non-empty file</param>
+        /// <returns>The mapped file, or nullptr if the file couldn't be opened or mapped</returns>
+        static std::unique_ptr<mapped_file> open(const std::string& path);
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+        virtual ~mapped_file();
+
+        uint8_t* get_data() const { return data; }
+        size_t get_size() const { return size; }
+    };
+
+}
@@ -0,0 +1,229 @@
+#include "profiler.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+
+using namespace isometric::tools;
+
+std::atomic<bool> profiler::enabled = false;
+thread_local Uint32 profile_zone::depth = 0;
+
+namespace {
+
+    struct zone_event
+    {
+        const char* name;
+        const char* category;
+        Uint64 start_tick;
+        Uint64 end_tick;
+        Uint32 depth;
+    };
+
+    // Only the thread that owns a buffer writes events to it (or allocates them), written is published after each
+    // event so that a reader knows which events are complete:
+    struct thread_buffer
+    {
+        std::vector<zone_event> events;
+        std::atomic<Uint64> written = 0;
+        std::atomic<Uint64> first_kept = 0;     // Events before this were thrown away by profiler::clear
+        Uint32 thread_id = 0;
+        std::string thread_name;                // Guarded by the registry mutex
+    };
+
+    struct buffer_registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<thread_buffer>> buffers;   // Kept after their threads exit so their zones remain
+        Uint64 epoch_tick = 0;
+    };
+
+    buffer_registry& get_registry()
+    {
+        static buffer_registry registry;
+        return registry;
+    }
+
+    thread_local thread_buffer* current_buffer = nullptr;
+
+    thread_buffer& get_thread_buffer()
+    {
+        if (current_buffer) return *current_buffer;
+
+        auto& registry = get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        auto buffer = std::make_unique<thread_buffer>();
+        buffer->thread_id = static_cast<Uint32>(registry.buffers.size() + 1);
+
+        current_buffer = buffer.get();
+        registry.buffers.push_back(std::move(buffer));
+        return *current_buffer;
+    }
+
+    void write_json_string(std::ofstream& out, const char* text)
+    {
+        out << '"';
+
+        for (const char* c = text; *c; c++)
+        {
+            switch (*c)
+            {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(*c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(*c));
+                    out << escaped;
+                }
+                else
+                {
+                    out << *c;
+                }
+            }
+        }
+
+        out << '"';
+    }
+}
+
+void profiler::set_enabled(bool enable)
+{
+    if (enable)
+    {
+        auto& registry = get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (registry.epoch_tick == 0) registry.epoch_tick = SDL_GetPerformanceCounter();
+    }
+
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+void profiler::set_thread_name(const std::string& name)
+{
+    thread_buffer& buffer = get_thread_buffer();
+
+    auto& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    buffer.thread_name = name;
+}
+
+const char* profiler::intern(const std::string& name)
+{
+    static std::mutex mutex;
+    static std::unordered_set<std::string> names;   // Nodes never move, so pointers to their strings stay valid
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return names.insert(name).first->c_str();
+}
+
+void profiler::record(const char* name, const char* category, Uint64 start_tick, Uint64 end_tick, Uint32 depth)
+{
+    thread_buffer& buffer = get_thread_buffer();
+
+    // Threads that never record a zone (such as while profiling is off) don't need the memory:
+    if (buffer.events.empty()) buffer.events.resize(events_per_thread);
+
+    const Uint64 index = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[index & (events_per_thread - 1)] = zone_event{ name, category, start_tick, end_tick, depth };
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void profiler::clear()
+{
+    auto& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (auto& buffer : registry.buffers)
+    {
+        buffer->first_kept.store(buffer->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+bool profiler::write_chrome_trace(const std::string& path)
+{
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open '%s' to write the profiler trace", path.c_str());
+        return false;
+    }
+
+    auto& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    const double microseconds_per_tick = 1000000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    std::vector<zone_event> events;
+    size_t event_count = 0;
+    bool first = true;
+    char number[64];
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    for (auto& buffer : registry.buffers)
+    {
+        // Thread names are metadata events:
+        if (!buffer->thread_name.empty())
+        {
+            out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << buffer->thread_id << ",\"args\":{\"name\":";
+            write_json_string(out, buffer->thread_name.c_str());
+            out << "}}";
+            first = false;
+        }
+
+        // Copy the events that are complete, then drop any that the thread wrote over while they were being copied:
+        const Uint64 end = buffer->written.load(std::memory_order_acquire);
+        const Uint64 begin = std::max(
+            buffer->first_kept.load(std::memory_order_relaxed),
+            end > events_per_thread ? end - events_per_thread : 0
+        );
+
+        events.clear();
+        for (Uint64 index = begin; index < end; index++)
+        {
+            events.push_back(buffer->events[index & (events_per_thread - 1)]);
+        }
+
+        const Uint64 written_after = buffer->written.load(std::memory_order_acquire);
+        const Uint64 overwritten = written_after > events_per_thread ? written_after - events_per_thread : 0;
+        const size_t skip = overwritten > begin ? static_cast<size_t>(std::min(overwritten - begin, end - begin)) : 0;
+
+        for (size_t i = skip; i < events.size(); i++)
+        {
+            const zone_event& e = events[i];
+            const Uint64 start = e.start_tick > registry.epoch_tick ? e.start_tick - registry.epoch_tick : 0;
+
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            write_json_string(out, e.name);
+            out << ",\"cat\":";
+            write_json_string(out, e.category);
+
+            std::snprintf(number, sizeof(number), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+                start * microseconds_per_tick, (e.end_tick - e.start_tick) * microseconds_per_tick);
+
+            out << number << ",\"pid\":1,\"tid\":" << buffer->thread_id << ",\"args\":{\"depth\":" << e.depth << "}}";
+            first = false;
+            event_count++;
+        }
+    }
+
+    out << "\n]}\n";
+    out.close();
+
+    if (!out)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write the profiler trace to '%s'", path.c_str());
+        return false;
+    }
+
+    SDL_Log("Wrote %zu profiler zones to '%s'", event_count, path.c_str());
+    return true;
+}
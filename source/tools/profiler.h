@@ -0,0 +1,93 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <string>
+
+namespace isometric::tools {
+
+    /// <summary>
+    /// Records timed zones (see profile_zone) into a ring buffer per thread and writes them out as a Chrome trace,
+    /// which chrome://tracing and ui.perfetto.dev can open. Recording a zone takes no locks: each thread only ever
+    /// writes to its own buffer, and a buffer keeps the most recent events_per_thread zones of its thread.
+    ///
+    /// Profiling is off until set_enabled(true) is called, while it's off a zone costs a single check.
+    /// </summary>
+    class profiler
+    {
+    public:
+        static constexpr size_t events_per_thread = 1 << 16;    // Must be a power of two
+
+        static void set_enabled(bool enable = true);
+        static bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+        /// <summary>
+        /// Name the calling thread in traces, threads without a name are shown by their id
+        /// </summary>
+        static void set_thread_name(const std::string& name);
+
+        /// <summary>
+        /// Get a copy of a string that lives as long as the program, for zone names that aren't string literals
+        /// </summary>
+        static const char* intern(const std::string& name);
+
+        /// <summary>
+        /// Write every recorded zone of every thread to a Chrome trace JSON file. Zones that are recorded while this
+        /// runs may be left out, so call it between frames (as the application does) for a complete trace.
+        /// </summary>
+        /// <returns>False if the file couldn't be written</returns>
+        static bool write_chrome_trace(const std::string& path);
+
+        /// <summary>
+        /// Forget every recorded zone, for example to only capture what happens after a level loaded
+        /// </summary>
+        static void clear();
+
+        static void record(const char* name, const char* category, Uint64 start_tick, Uint64 end_tick, Uint32 depth);
+
+    private:
+        static std::atomic<bool> enabled;
+    };
+
+    /// <summary>
+    /// Times the scope it lives in, zones within zones on the same thread are shown nested in the trace.
+    ///
+    ///  void world::render_frame(...)
+    ///  {
+    ///      tools::profile_zone zone("world::render_frame");
+    ///      ...
+    ///  }
+    /// </summary>
+    class profile_zone
+    {
+    private:
+        const char* name;
+        const char* category;
+        Uint64 start_tick = 0;
+        static thread_local Uint32 depth;
+
+    public:
+        /// <param name="name">Must live as long as the program, a string literal or from profiler::intern</param>
+        /// <param name="category">Shown as the zone's category in the trace, same lifetime rules as name</param>
+        explicit profile_zone(const char* name, const char* category = "engine")
+            : name(profiler::is_enabled() ? name : nullptr), category(category)
+        {
+            if (!this->name) return;
+
+            depth++;
+            start_tick = SDL_GetPerformanceCounter();
+        }
+
+        ~profile_zone()
+        {
+            if (!name) return;
+
+            const Uint64 end_tick = SDL_GetPerformanceCounter();
+            depth--;
+            profiler::record(name, category, start_tick, end_tick, depth);
+        }
+
+        profile_zone(const profile_zone&) = delete;
+        profile_zone& operator=(const profile_zone&) = delete;
+    };
+
+}